@@ -0,0 +1,159 @@
+#include <nanoreflex/bvh.hpp>
+
+namespace nanoreflex {
+
+namespace {
+
+constexpr auto empty_box() noexcept -> aabb3 {
+  aabb3 result{};
+  result._min = vec3{infinity};
+  result._max = vec3{-infinity};
+  return result;
+}
+
+constexpr auto surface_area(const aabb3& box) noexcept -> real {
+  const auto d = max(box._max - box._min, vec3{0});
+  return 2 * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+}  // namespace
+
+auto bvh_from(const vector<aabb3>& boxes, bvh::index_type leaf_size) -> bvh {
+  using index_type = bvh::index_type;
+  constexpr index_type bin_count = 16;
+  // After this depth, only median splits are used.
+  // So, the tree depth stays bounded by the traversal stack size.
+  constexpr size_t max_sah_depth = 30;
+
+  bvh tree{};
+  if (boxes.empty()) return tree;
+  leaf_size = std::max(leaf_size, index_type(1));
+
+  tree.primitives.resize(boxes.size());
+  iota(begin(tree.primitives), end(tree.primitives), index_type(0));
+
+  vector<vec3> centroids(boxes.size());
+  for (size_t i = 0; i < boxes.size(); ++i) centroids[i] = boxes[i].origin();
+
+  tree.nodes.reserve(2 * boxes.size() / leaf_size + 1);
+  tree.nodes.push_back({.offset = 0, .count = index_type(boxes.size())});
+
+  struct task {
+    index_type node;
+    size_t depth;
+  };
+  vector<task> tasks{{0, 0}};
+
+  while (!tasks.empty()) {
+    const auto [n, depth] = tasks.back();
+    tasks.pop_back();
+
+    const auto offset = tree.nodes[n].offset;
+    const auto count = tree.nodes[n].count;
+    const auto first = begin(tree.primitives) + offset;
+    const auto last = first + count;
+
+    // Compute the bounding box of all primitives
+    // and the bounding box of their centroids.
+    //
+    auto box = empty_box();
+    auto centroid_box = empty_box();
+    for (auto it = first; it != last; ++it) {
+      box = aabb(box, boxes[*it]);
+      centroid_box = aabb(centroid_box, centroids[*it]);
+    }
+    tree.nodes[n].box = box;
+
+    if (count <= leaf_size) continue;
+
+    // Only split along the axis with the largest centroid extent.
+    //
+    const auto extent = centroid_box._max - centroid_box._min;
+    int axis = 0;
+    if (extent[1] > extent[axis]) axis = 1;
+    if (extent[2] > extent[axis]) axis = 2;
+
+    auto middle = first;
+    if (extent[axis] <= 0) {
+      // All centroids coincide and no split will separate them.
+      // Only oversized leaves are halved to bound the leaf size.
+      if (count <= 4 * leaf_size) continue;
+      middle = first + count / 2;
+    } else if (depth < max_sah_depth) {
+      // Fill the bins with primitives by their centroid.
+      //
+      const auto scale = bin_count / extent[axis];
+      const auto bin = [&](index_type i) {
+        return std::min(
+            index_type((centroids[i][axis] - centroid_box._min[axis]) * scale),
+            bin_count - 1);
+      };
+      array<aabb3, bin_count> bin_boxes;
+      bin_boxes.fill(empty_box());
+      array<index_type, bin_count> bin_counts{};
+      for (auto it = first; it != last; ++it) {
+        const auto b = bin(*it);
+        bin_boxes[b] = aabb(bin_boxes[b], boxes[*it]);
+        ++bin_counts[b];
+      }
+
+      // Sweep from the right to get the cost of all right partitions.
+      //
+      array<real, bin_count> right_costs{};
+      auto right_box = empty_box();
+      index_type right_count = 0;
+      for (auto b = bin_count - 1; b > 0; --b) {
+        right_box = aabb(right_box, bin_boxes[b]);
+        right_count += bin_counts[b];
+        right_costs[b] = right_count * surface_area(right_box);
+      }
+
+      // Sweep from the left and find the split with the lowest cost.
+      //
+      auto left_box = empty_box();
+      index_type left_count = 0;
+      auto best_cost = infinity;
+      index_type best_split = 0;
+      for (index_type b = 1; b < bin_count; ++b) {
+        left_box = aabb(left_box, bin_boxes[b - 1]);
+        left_count += bin_counts[b - 1];
+        const auto cost = left_count * surface_area(left_box) + right_costs[b];
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_split = b;
+        }
+      }
+
+      // Keep small leaves if splitting would not pay off.
+      //
+      const auto leaf_cost = count * surface_area(box);
+      if (best_cost >= leaf_cost && count <= 4 * leaf_size) continue;
+
+      middle = std::partition(
+          first, last, [&](index_type i) { return bin(i) < best_split; });
+    }
+
+    // Degenerated partitions and deep nodes use the median.
+    //
+    if (middle == first || middle == last) {
+      middle = first + count / 2;
+      nth_element(first, middle, last, [&](index_type i, index_type j) {
+        return centroids[i][axis] < centroids[j][axis];
+      });
+    }
+
+    const auto left_count = index_type(middle - first);
+    const auto left = index_type(tree.nodes.size());
+    tree.nodes.push_back({.offset = offset, .count = left_count});
+    tree.nodes.push_back(
+        {.offset = offset + left_count, .count = count - left_count});
+    tree.nodes[n].offset = left;
+    tree.nodes[n].count = 0;
+    tasks.push_back({left, depth + 1});
+    tasks.push_back({left + 1, depth + 1});
+  }
+
+  return tree;
+}
+
+}  // namespace nanoreflex
@@ -0,0 +1,94 @@
+#pragma once
+#include <nanoreflex/aabb.hpp>
+
+namespace nanoreflex {
+
+/// Binary bounding volume hierarchy over an abstract set of primitives.
+/// The primitives themselves are only known by their bounding boxes
+/// and are referenced by their index in the range used for construction.
+/// The two children of an inner node are always stored adjacently.
+/// So, a node only needs to store the index of its first child.
+///
+struct bvh {
+  using index_type = uint32;
+
+  struct node {
+    constexpr bool leaf() const noexcept { return count != 0; }
+
+    aabb3 box{};
+    // For inner nodes, the index of the first child node.
+    // For leaves, the index of the first primitive in 'primitives'.
+    index_type offset{};
+    // The number of primitives in a leaf or zero for inner nodes.
+    index_type count{};
+  };
+
+  constexpr bool empty() const noexcept { return nodes.empty(); }
+  constexpr auto root() const noexcept -> const node& { return nodes.front(); }
+  constexpr auto box() const noexcept -> aabb3 { return root().box; }
+
+  /// Return the primitive indices that are referenced by the given leaf.
+  ///
+  constexpr auto leaf_primitives(const node& leaf) const noexcept {
+    assert(leaf.leaf());
+    return span(&primitives[leaf.offset], leaf.count);
+  }
+
+  /// Number of bytes used by the hierarchy without the primitives itself.
+  ///
+  constexpr auto memory_usage() const noexcept -> size_t {
+    return nodes.size() * sizeof(node) +
+           primitives.size() * sizeof(index_type);
+  }
+
+  vector<node> nodes{};
+  vector<index_type> primitives{};
+};
+
+/// Construct a BVH for the given primitive bounding boxes
+/// by using binned surface area heuristics.
+///
+auto bvh_from(const vector<aabb3>& boxes, bvh::index_type leaf_size = 4)
+    -> bvh;
+
+/// Recompute all bounding boxes of the hierarchy
+/// without changing its topology.
+/// 'primitive_box(index)' has to return the new box of the given primitive.
+/// Children are always stored after their parent.
+/// So, a reversed linear sweep visits children first.
+///
+inline void refit(bvh& tree, auto&& primitive_box) {
+  for (auto i = tree.nodes.size(); i-- > 0;) {
+    auto& node = tree.nodes[i];
+    if (node.leaf()) {
+      const auto primitives = tree.leaf_primitives(node);
+      node.box = primitive_box(primitives[0]);
+      for (auto p : primitives) node.box = aabb(node.box, primitive_box(p));
+    } else
+      node.box = aabb(tree.nodes[node.offset].box,
+                      tree.nodes[node.offset + 1].box);
+  }
+}
+
+/// Call 'process(primitives)' for every leaf of the hierarchy
+/// whose boxes along the path to the root all fulfill 'accept(box)'.
+///
+inline void for_each_leaf(const bvh& tree, auto&& accept, auto&& process) {
+  if (tree.empty()) return;
+  if (!accept(tree.box())) return;
+
+  bvh::index_type stack[64];
+  size_t top = 0;
+  stack[top++] = 0;
+  while (top > 0) {
+    const auto& node = tree.nodes[stack[--top]];
+    if (node.leaf()) {
+      process(tree.leaf_primitives(node));
+      continue;
+    }
+    for (auto i = node.offset; i < node.offset + 2; ++i)
+      if (accept(tree.nodes[i].box)) stack[top++] = i;
+  }
+}
+
+}  // namespace nanoreflex
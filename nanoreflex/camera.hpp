@@ -1,4 +1,5 @@
 #pragma once
+#include <nanoreflex/frustum.hpp>
 #include <nanoreflex/ray_tracer.hpp>
 
 namespace nanoreflex {
@@ -67,6 +68,33 @@ class camera {
                                          (0.5f * screen_height() - y) * up()))};
   }
 
+  /// Frustum of all points in front of the camera
+  /// that are projected into the given rectangle of the screen.
+  ///
+  auto sub_frustum(float x0, float y0, float x1, float y1) const -> frustum {
+    // Rectangles need to have a positive area to produce valid planes.
+    const auto left = std::min(x0, x1);
+    const auto right = std::max(std::max(x0, x1), left + 1);
+    const auto top = std::min(y0, y1);
+    const auto bottom = std::max(std::max(y0, y1), top + 1);
+
+    const array<vec3, 4> corners{primary_ray(left, top).direction,
+                                 primary_ray(right, top).direction,
+                                 primary_ray(right, bottom).direction,
+                                 primary_ray(left, bottom).direction};
+    const auto center = corners[0] + corners[1] + corners[2] + corners[3];
+
+    frustum result{};
+    for (size_t i = 0; i < corners.size(); ++i) {
+      auto n = normalize(cross(corners[i], corners[(i + 1) % 4]));
+      if (dot(n, center) < 0) n = -n;
+      result.planes.push_back({n, -dot(n, position())});
+    }
+    result.planes.push_back(
+        {direction(), -dot(direction(), position()) - near()});
+    return result;
+  }
+
   constexpr auto set_screen_resolution(int w, int h) noexcept -> camera& {
     pixels.x = w;
     pixels.y = h;
@@ -0,0 +1,222 @@
+#include <nanoreflex/closest_point.hpp>
+#include <nanoreflex/parallel.hpp>
+
+namespace nanoreflex {
+
+namespace {
+
+auto distance2(const vec3& p, const aabb3& box) noexcept -> float {
+  const auto d = max(max(box._min - p, p - box._max), vec3{0.0f});
+  return dot(d, d);
+}
+
+// Best-first traversal of a BVH with respect to the distance to a point.
+// 'dmax' references the squared distance of the current closest point
+// and is used to prune all nodes that are farther away.
+// The leaf function is responsible for updating 'dmax'.
+//
+void traverse(const vec3& p,
+              const bvh& tree,
+              const float& dmax,
+              auto&& process) noexcept {
+  if (tree.empty()) return;
+
+  struct entry {
+    bvh::index_type node;
+    float d;
+  };
+  entry stack[64];
+  size_t top = 0;
+  stack[top++] = {0, distance2(p, tree.box())};
+
+  while (top > 0) {
+    const auto [n, d] = stack[--top];
+    if (d >= dmax) continue;
+    const auto& node = tree.nodes[n];
+    if (node.leaf()) {
+      process(tree.leaf_primitives(node));
+      continue;
+    }
+    const auto left = node.offset;
+    const auto right = node.offset + 1;
+    const auto l = distance2(p, tree.nodes[left].box);
+    const auto r = distance2(p, tree.nodes[right].box);
+    // Push the farther child first to process the nearer one first.
+    if (l <= r) {
+      if (r < dmax) stack[top++] = {right, r};
+      if (l < dmax) stack[top++] = {left, l};
+    } else {
+      if (l < dmax) stack[top++] = {left, l};
+      if (r < dmax) stack[top++] = {right, r};
+    }
+  }
+}
+
+// Best-first traversal of a compressed four-wide BVH.
+// Leaves are pushed onto the stack like nodes
+// to also process them in the order of their distance.
+//
+void traverse(const vec3& p,
+              const wide_bvh& tree,
+              const float& dmax,
+              auto&& process) noexcept {
+  constexpr auto width = wide_bvh::width;
+  if (tree.empty()) return;
+
+  struct entry {
+    wide_bvh::index_type index;
+    uint32 count;
+    float d;
+  };
+  entry stack[3 * 64 + width];
+  size_t top = 0;
+  stack[top++] = {0, 0, distance2(p, tree.box())};
+
+  while (top > 0) {
+    const auto [index, count, d] = stack[--top];
+    if (d >= dmax) continue;
+    if (count != 0) {
+      process(span(&tree.primitives[index], count));
+      continue;
+    }
+
+    const auto& node = tree.nodes[index];
+    const auto s = node.scale();
+    const auto offset = [&](int k, uint8 lo, uint8 hi) {
+      const auto min = node.origin[k] + s[k] * lo;
+      const auto max = node.origin[k] + s[k] * hi;
+      return std::max(std::max(min - p[k], p[k] - max), 0.0f);
+    };
+
+    // Distances to all children in a structure-of-arrays layout.
+    //
+    float distances[width];
+    for (size_t i = 0; i < width; ++i) {
+      const auto x = offset(0, node.lo[0][i], node.hi[0][i]);
+      const auto y = offset(1, node.lo[1][i], node.hi[1][i]);
+      const auto z = offset(2, node.lo[2][i], node.hi[2][i]);
+      distances[i] = x * x + y * y + z * z;
+    }
+
+    // Push the farthest child first.
+    //
+    size_t hits[width];
+    size_t n = 0;
+    for (size_t i = 0; i < width; ++i) {
+      if (node.empty(i) || distances[i] >= dmax) continue;
+      auto j = n++;
+      for (; j > 0 && distances[hits[j - 1]] < distances[i]; --j)
+        hits[j] = hits[j - 1];
+      hits[j] = i;
+    }
+    for (size_t j = 0; j < n; ++j) {
+      const auto i = hits[j];
+      stack[top++] = {node.child[i], node.count[i], distances[i]};
+    }
+  }
+}
+
+void project(const vec3& p,
+             const polyhedral_surface& surface,
+             const wide_bvh& tree,
+             point_polyhedral_surface_projection& result) noexcept {
+  traverse(p, tree, result.distance2, [&](auto fids) {
+    const auto& v = surface.vertices;
+    for (auto fid : fids) {
+      const auto& f = surface.faces[fid];
+      const auto q = closest_point(
+          p, {v[f[0]].position, v[f[1]].position, v[f[2]].position});
+      if (q.distance2 >= result.distance2) continue;
+      static_cast<point_triangle_projection&>(result) = q;
+      result.f = fid;
+    }
+  });
+}
+
+}  // namespace
+
+auto closest_point(const vec3& p, const triangle& f) noexcept
+    -> point_triangle_projection {
+  // Classify the point with respect to the Voronoi regions
+  // of the vertices, edges, and the face of the triangle.
+  //
+  const auto project = [&](float u, float v) -> point_triangle_projection {
+    const auto q = f[0] + u * (f[1] - f[0]) + v * (f[2] - f[0]);
+    return {u, v, length2(p - q)};
+  };
+
+  const auto ab = f[1] - f[0];
+  const auto ac = f[2] - f[0];
+  const auto ap = p - f[0];
+  const auto d1 = dot(ab, ap);
+  const auto d2 = dot(ac, ap);
+  if (d1 <= 0 && d2 <= 0) return project(0, 0);
+
+  const auto bp = p - f[1];
+  const auto d3 = dot(ab, bp);
+  const auto d4 = dot(ac, bp);
+  if (d3 >= 0 && d4 <= d3) return project(1, 0);
+
+  const auto vc = d1 * d4 - d3 * d2;
+  if (vc <= 0 && d1 >= 0 && d3 <= 0) return project(d1 / (d1 - d3), 0);
+
+  const auto cp = p - f[2];
+  const auto d5 = dot(ab, cp);
+  const auto d6 = dot(ac, cp);
+  if (d6 >= 0 && d5 <= d6) return project(0, 1);
+
+  const auto vb = d5 * d2 - d1 * d6;
+  if (vb <= 0 && d2 >= 0 && d6 <= 0) return project(0, d2 / (d2 - d6));
+
+  const auto va = d3 * d6 - d5 * d4;
+  if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) {
+    const auto t = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+    return project(1 - t, t);
+  }
+
+  const auto denominator = 1 / (va + vb + vc);
+  return project(vb * denominator, vc * denominator);
+}
+
+auto closest_point(const vec3& p, const polyhedral_surface& surface) noexcept
+    -> point_polyhedral_surface_projection {
+  point_polyhedral_surface_projection result{};
+  const auto& v = surface.vertices;
+  for (size_t i = 0; i < surface.faces.size(); ++i) {
+    const auto& f = surface.faces[i];
+    const auto q = closest_point(
+        p, {v[f[0]].position, v[f[1]].position, v[f[2]].position});
+    if (q.distance2 >= result.distance2) continue;
+    static_cast<point_triangle_projection&>(result) = q;
+    result.f = i;
+  }
+  return result;
+}
+
+auto closest_point(const vec3& p,
+                   const polyhedral_surface& surface,
+                   const surface_bvh& tree) noexcept
+    -> point_polyhedral_surface_projection {
+  point_polyhedral_surface_projection result{};
+  traverse(p, tree.top, result.distance2, [&](auto cids) {
+    for (auto cid : cids) {
+      if (!tree.visible(cid)) continue;
+      project(p, surface, tree.components[cid], result);
+    }
+  });
+  return result;
+}
+
+auto closest_points(span<const vec3> points,
+                    const polyhedral_surface& surface,
+                    const surface_bvh& tree)
+    -> vector<point_polyhedral_surface_projection> {
+  vector<point_polyhedral_surface_projection> result(points.size());
+  parallel_for(
+      0, points.size(),
+      [&](size_t i) { result[i] = closest_point(points[i], surface, tree); },
+      64);
+  return result;
+}
+
+}  // namespace nanoreflex
@@ -0,0 +1,45 @@
+#pragma once
+#include <nanoreflex/ray_tracer.hpp>
+#include <nanoreflex/surface_bvh.hpp>
+
+namespace nanoreflex {
+
+/// The closest point on a triangle is given by barycentric coordinates.
+/// The point itself can be reconstructed by 'w * f[0] + u * f[1] + v * f[2]'
+/// with 'w = 1 - u - v'.
+///
+struct point_triangle_projection {
+  float u{};
+  float v{};
+  // Squared Euclidean distance of the query point to the closest point.
+  float distance2 = infinity;
+};
+
+auto closest_point(const vec3& p, const triangle& f) noexcept
+    -> point_triangle_projection;
+
+struct point_polyhedral_surface_projection : point_triangle_projection {
+  operator bool() const noexcept { return f != -1; }
+  uint32 f = -1;
+};
+
+/// Brute-force search over all faces of the surface.
+///
+auto closest_point(const vec3& p, const polyhedral_surface& surface) noexcept
+    -> point_polyhedral_surface_projection;
+
+/// Accelerated search over all visible components of the surface.
+///
+auto closest_point(const vec3& p,
+                   const polyhedral_surface& surface,
+                   const surface_bvh& tree) noexcept
+    -> point_polyhedral_surface_projection;
+
+/// Project many points at once by distributing them over all threads.
+///
+auto closest_points(span<const vec3> points,
+                    const polyhedral_surface& surface,
+                    const surface_bvh& tree)
+    -> vector<point_polyhedral_surface_projection>;
+
+}  // namespace nanoreflex
@@ -0,0 +1,93 @@
+#include <nanoreflex/curve_worker.hpp>
+
+namespace nanoreflex {
+
+namespace {
+
+// Replace all strip entries of 'dst' from index 'first' on
+// and their edge weights by the ones of 'src'.
+//
+void copy_suffix(const polyhedral_surface::surface_mesh_curve& src,
+                 size_t first,
+                 polyhedral_surface::surface_mesh_curve& dst) {
+  dst.face_strip.resize(first);
+  dst.face_strip.insert(end(dst.face_strip), begin(src.face_strip) + first,
+                        end(src.face_strip));
+  const auto weights = (first > 0) ? first - 1 : 0;
+  dst.edge_weights.resize(weights);
+  dst.edge_weights.insert(end(dst.edge_weights),
+                          begin(src.edge_weights) + weights,
+                          end(src.edge_weights));
+}
+
+}  // namespace
+
+curve_worker::curve_worker(const polyhedral_surface& surface,
+                           const surface_bvh& tree,
+                           face_search& search)
+    : surface{surface}, tree{tree}, search{search}, worker{[this] { run(); }} {}
+
+curve_worker::~curve_worker() {
+  {
+    scoped_lock lock{state_mutex};
+    stopping = true;
+  }
+  requested.notify_one();
+  worker.join();
+}
+
+void curve_worker::request(const ray& r) {
+  {
+    scoped_lock lock{state_mutex};
+    pending = r;
+  }
+  requested.notify_one();
+}
+
+void curve_worker::wait() {
+  unique_lock lock{state_mutex};
+  idle.wait(lock, [this] { return !busy && !pending; });
+}
+
+void curve_worker::clear() {
+  wait();
+  scoped_lock lock{state_mutex};
+  curve.clear();
+  published.clear();
+  first_change = {};
+}
+
+auto curve_worker::fetch(curve_type& result) -> optional<size_t> {
+  scoped_lock lock{state_mutex};
+  const auto first = first_change;
+  if (first) copy_suffix(published, *first, result);
+  first_change = {};
+  return first;
+}
+
+void curve_worker::run() {
+  unique_lock lock{state_mutex};
+  while (true) {
+    requested.wait(lock, [this] { return stopping || pending; });
+    if (stopping) return;
+    const auto r = *pending;
+    pending = {};
+    busy = true;
+    lock.unlock();
+
+    auto first = curve.face_strip.size();
+    if (const auto p = intersection(r, surface, tree))
+      first = surface.add_face(curve, p.f, search);
+
+    lock.lock();
+    if (first < curve.face_strip.size() ||
+        curve.face_strip.size() != published.face_strip.size()) {
+      copy_suffix(curve, first, published);
+      first_change = std::min(first_change.value_or(first), first);
+    }
+    busy = false;
+    if (!pending) idle.notify_all();
+  }
+}
+
+}  // namespace nanoreflex
@@ -0,0 +1,74 @@
+#pragma once
+#include <nanoreflex/face_search.hpp>
+#include <nanoreflex/ray_tracer.hpp>
+
+namespace nanoreflex {
+
+/// Background thread for interactive drawing of surface mesh curves.
+/// Picking faces and searching face paths on large meshes
+/// would otherwise stall the render loop for every mouse move.
+///
+/// Only the latest request counts.
+/// A new request replaces a pending one that has not been started yet.
+/// Finished extensions of the curve are published as changed suffixes
+/// which the render loop fetches into its own copy of the curve.
+/// So, the render loop only pays for the parts of the curve that changed.
+///
+/// The surface, its hierarchy, and the search workspace are shared.
+/// They must not be modified unless the worker has been waited for.
+///
+class curve_worker {
+ public:
+  using curve_type = polyhedral_surface::surface_mesh_curve;
+
+  curve_worker(const polyhedral_surface& surface,
+               const surface_bvh& tree,
+               face_search& search);
+  ~curve_worker();
+
+  // Copying and moving is not allowed due to the running thread.
+  curve_worker(const curve_worker&) = delete;
+  curve_worker& operator=(const curve_worker&) = delete;
+
+  /// Extend the curve by the face hit by the given ray.
+  ///
+  void request(const ray& r);
+
+  /// Block until no request is pending or in progress.
+  ///
+  void wait();
+
+  /// Remove all faces of the curve after waiting for the worker.
+  ///
+  void clear();
+
+  /// Apply all changes published since the last call to the given curve.
+  /// Return the index of the first changed strip entry
+  /// or nothing if the curve has not changed.
+  ///
+  auto fetch(curve_type& curve) -> optional<size_t>;
+
+ private:
+  void run();
+
+  const polyhedral_surface& surface;
+  const surface_bvh& tree;
+  face_search& search;
+
+  mutex state_mutex{};
+  condition_variable requested{};
+  condition_variable idle{};
+  optional<ray> pending{};
+  bool busy = false;
+  bool stopping = false;
+
+  // The worker extends its own curve without holding the lock
+  // and afterwards only copies the changed suffix to the published one.
+  curve_type curve{};
+  curve_type published{};
+  optional<size_t> first_change{};
+
+  thread worker{};
+};
+
+}  // namespace nanoreflex
@@ -72,6 +72,18 @@ struct discrete_quotient_map {
     inverse_offset[0] = 0;
   }
 
+  /// Append a new element to the domain as its own equivalence class.
+  /// The new class is the last one in the inverse mapping.
+  /// So, nothing has to be regenerated.
+  ///
+  constexpr auto push_back() -> image_type {
+    const auto y = image_type(image_size());
+    labels.push_back(y);
+    inverse.push_back(image_type(labels.size() - 1));
+    inverse_offset.push_back(image_type(inverse.size()));
+    return y;
+  }
+
   constexpr auto operator()(domain_type x) const noexcept -> image_type {
     assert(x < domain_size());
     return labels[x];
@@ -106,4 +118,94 @@ struct discrete_quotient_map {
   vector<image_type> inverse{};
 };
 
+/// Quotient map whose classes can change locally.
+/// Every class stores its elements in its own array
+/// and every element knows its position inside of it.
+/// So, elements are appended to a class or moved to another one
+/// without touching any other element.
+/// This suits few large classes, like the components of a surface,
+/// but not many small ones, like topological vertices.
+///
+template <unsigned_integral type1, unsigned_integral type2>
+struct dynamic_quotient_map {
+  using domain_type = type1;
+  using image_type = type2;
+
+  dynamic_quotient_map() = default;
+  constexpr dynamic_quotient_map(ranges::input_range auto&& input,
+                                 image_type count)
+      : labels(std::forward<decltype(input)>(input)),
+        positions(labels.size()),
+        classes(count) {
+    for (size_t x = 0; x < labels.size(); ++x) {
+      auto& c = classes[labels[x]];
+      positions[x] = c.size();
+      c.push_back(x);
+    }
+  }
+
+  constexpr auto domain_size() const noexcept { return labels.size(); }
+  constexpr auto image_size() const noexcept { return classes.size(); }
+
+  constexpr auto operator()(domain_type x) const noexcept -> image_type {
+    assert(x < domain_size());
+    return labels[x];
+  }
+
+  constexpr auto operator[](image_type y) const noexcept {
+    assert(y < image_size());
+    return span<const domain_type>(classes[y]);
+  }
+
+  /// Append a new element to the domain inside the given class.
+  ///
+  constexpr auto push_back(image_type y) -> domain_type {
+    assert(y < image_size());
+    const auto x = domain_type(labels.size());
+    labels.push_back(y);
+    positions.push_back(classes[y].size());
+    classes[y].push_back(x);
+    return x;
+  }
+
+  /// Add a new empty class at the end.
+  ///
+  constexpr auto add_class() -> image_type {
+    classes.emplace_back();
+    return image_type(classes.size() - 1);
+  }
+
+  /// Move an element to the given class.
+  /// The last element of its old class takes over its position.
+  ///
+  constexpr void relabel(domain_type x, image_type y) {
+    assert((x < domain_size()) && (y < image_size()));
+    auto& c = classes[labels[x]];
+    const auto last = c.back();
+    c[positions[x]] = last;
+    positions[last] = positions[x];
+    c.pop_back();
+    labels[x] = y;
+    positions[x] = classes[y].size();
+    classes[y].push_back(x);
+  }
+
+  constexpr bool valid() const noexcept {
+    size_t count = 0;
+    for (size_t y = 0; y < classes.size(); ++y) {
+      count += classes[y].size();
+      for (size_t i = 0; i < classes[y].size(); ++i) {
+        const auto x = classes[y][i];
+        if ((labels[x] != y) || (positions[x] != i)) return false;
+      }
+    }
+    return count == labels.size();
+  }
+
+ private:
+  vector<image_type> labels{};
+  vector<domain_type> positions{};
+  vector<vector<domain_type>> classes{};
+};
+
 }  // namespace nanoreflex
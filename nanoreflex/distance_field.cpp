@@ -0,0 +1,155 @@
+#include <nanoreflex/distance_field.hpp>
+//
+#include <nanoreflex/parallel.hpp>
+
+namespace nanoreflex {
+
+namespace {
+
+// The tentative distance and the predecessor of a face are packed
+// into a single word to update both by one compare-and-swap.
+// Non-negative floats are ordered like their bit patterns.
+// So, the packed words are ordered by their distances.
+//
+constexpr auto pack(float32 distance, uint32 previous) noexcept -> uint64 {
+  return (uint64(bit_cast<uint32>(distance)) << 32) | previous;
+}
+constexpr auto unpacked_distance(uint64 x) noexcept -> float32 {
+  return bit_cast<float32>(uint32(x >> 32));
+}
+constexpr auto unpacked_previous(uint64 x) noexcept -> uint32 {
+  return uint32(x);
+}
+
+/// Atomically lower the distance of a face
+/// and return whether the given one has been smaller.
+///
+inline bool relax(atomic<uint64>& state,
+                  float32 distance,
+                  uint32 previous) noexcept {
+  const auto x = pack(distance, previous);
+  auto old = state.load(memory_order_relaxed);
+  while ((old >> 32) > (x >> 32))
+    if (state.compare_exchange_weak(old, x, memory_order_relaxed)) return true;
+  return false;
+}
+
+auto mean_weight(const polyhedral_surface& surface) noexcept -> float32 {
+  float64 sum = 0;
+  size_t count = 0;
+  for (const auto& weights : surface.face_adjacency_weights)
+    for (auto w : weights) {
+      if (w == infinity) continue;
+      sum += w;
+      ++count;
+    }
+  return (count == 0) ? 1.0f : float32(sum / count);
+}
+
+}  // namespace
+
+auto face_distance_field_from(const polyhedral_surface& surface,
+                              span<const polyhedral_surface::face_id> sources,
+                              float32 delta) -> face_distance_field {
+  using face_id = polyhedral_surface::face_id;
+  constexpr auto invalid = polyhedral_surface::invalid;
+  const auto n = surface.faces.size();
+
+  vector<atomic<uint64>> states(n);
+  parallel_for(0, n, [&](size_t fid) {
+    states[fid].store(pack(infinity, invalid), memory_order_relaxed);
+  });
+
+  // A few edges per bucket keep enough parallel work
+  // without relaxing too many faces more than once.
+  if (delta <= 0) delta = 4 * mean_weight(surface);
+
+  vector<vector<face_id>> buckets{};
+  const auto bucket = [&](float32 d) { return size_t(d / delta); };
+  const auto insert = [&](face_id fid, size_t b) {
+    if (b >= buckets.size()) buckets.resize(b + 1);
+    buckets[b].push_back(fid);
+  };
+
+  for (auto src : sources) {
+    states[src].store(pack(0, src << 2), memory_order_relaxed);
+    insert(src, 0);
+  }
+
+  // Every round relaxes the current frontier in parallel.
+  // Large surfaces need thousands of mostly narrow rounds.
+  // Spawning threads for each of them would dominate the run time.
+  // So, one team of workers runs all rounds
+  // and only meets at a barrier between them.
+  // The last one to arrive takes the next frontier
+  // from the smallest non-empty bucket.
+  // Relaxations may refill the current bucket.
+  //
+  constexpr size_t grain = 1024;
+  size_t b = 0;
+  vector<face_id> frontier{};
+  atomic<size_t> next{0};
+  const auto advance = [&]() noexcept {
+    while ((b < buckets.size()) && buckets[b].empty()) ++b;
+    frontier.clear();
+    if (b < buckets.size()) swap(frontier, buckets[b]);
+    next.store(0, memory_order_relaxed);
+  };
+  advance();
+
+  const auto workers = thread_count();
+  barrier sync(ptrdiff_t(workers), advance);
+  mutex buckets_mutex{};
+  const auto work = [&] {
+    vector<pair<face_id, size_t>> updates{};
+    while (!frontier.empty()) {
+      const auto size = frontier.size();
+      for (auto first = next.fetch_add(grain); first < size;
+           first = next.fetch_add(grain)) {
+        const auto last = std::min(first + grain, size);
+        for (auto k = first; k < last; ++k) {
+          const auto fid = frontier[k];
+          const auto d =
+              unpacked_distance(states[fid].load(memory_order_relaxed));
+          // The face has been moved to a smaller bucket in the meantime.
+          if (bucket(d) != b) continue;
+
+          for (uint32 i = 0; i < 3; ++i) {
+            const auto a = surface.face_adjacencies[fid][i];
+            if (a == invalid) continue;
+            const auto neighbor = a >> 2;
+            const auto nd = d + surface.face_adjacency_weights[fid][i];
+            if (relax(states[neighbor], nd, (fid << 2) | i))
+              updates.push_back({neighbor, std::max(bucket(nd), b)});
+          }
+        }
+      }
+
+      if (!updates.empty()) {
+        scoped_lock lock{buckets_mutex};
+        for (const auto& [fid, nb] : updates) insert(fid, nb);
+      }
+      updates.clear();
+      sync.arrive_and_wait();
+    }
+  };
+
+  vector<future<void>> tasks{};
+  tasks.reserve(workers - 1);
+  for (size_t i = 1; i < workers; ++i)
+    tasks.push_back(async(launch::async, work));
+  work();
+  for (auto& task : tasks) task.get();
+
+  face_distance_field field{};
+  field.distances.resize(n);
+  field.previous.resize(n);
+  parallel_for(0, n, [&](size_t fid) {
+    const auto x = states[fid].load(memory_order_relaxed);
+    field.distances[fid] = unpacked_distance(x);
+    field.previous[fid] = unpacked_previous(x);
+  });
+  return field;
+}
+
+}  // namespace nanoreflex
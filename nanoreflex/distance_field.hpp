@@ -0,0 +1,40 @@
+#pragma once
+#include <nanoreflex/polyhedral_surface.hpp>
+
+namespace nanoreflex {
+
+/// Shortest face path distances from a set of source faces to all faces
+/// measured in the dual graph of the surface.
+/// Like in 'face_search', predecessors are given by '(pfid << 2) | loc'
+/// and sources are their own predecessor.
+/// Unreachable faces have an infinite distance and an invalid predecessor.
+///
+struct face_distance_field {
+  using face_id = polyhedral_surface::face_id;
+  template <typename type>
+  using face_map = polyhedral_surface::face_map<type>;
+
+  auto size() const noexcept { return distances.size(); }
+  bool reached(face_id fid) const noexcept {
+    return distances[fid] != infinity;
+  }
+
+  face_map<float32> distances{};
+  face_map<uint32> previous{};
+};
+
+/// Compute the distance field by parallel delta-stepping.
+/// Faces are put into buckets of width 'delta' by their tentative distance.
+/// All faces of the smallest non-empty bucket are relaxed in parallel
+/// until the bucket stays empty.
+/// The worker threads are started once and meet between these rounds.
+/// Small values approach Dijkstra's algorithm
+/// while large values approach the Bellman-Ford algorithm.
+/// A non-positive 'delta' is chosen by the mean edge weight.
+/// The dual graph of the surface needs to be generated before.
+///
+auto face_distance_field_from(const polyhedral_surface& surface,
+                              span<const polyhedral_surface::face_id> sources,
+                              float32 delta = 0) -> face_distance_field;
+
+}  // namespace nanoreflex
@@ -0,0 +1,65 @@
+#include <nanoreflex/face_landmarks.hpp>
+//
+#include <nanoreflex/distance_field.hpp>
+#include <nanoreflex/parallel.hpp>
+
+namespace nanoreflex {
+
+auto face_landmarks_from(const polyhedral_surface& surface, size_t count)
+    -> face_landmarks {
+  using face_id = face_landmarks::face_id;
+  const auto n = surface.faces.size();
+  face_landmarks result{};
+  if (n == 0 || count == 0) return result;
+
+  // Distance of every face to its closest landmark.
+  vector<float32> closest(n, infinity);
+  const auto farthest = [&] {
+    face_id fid = 0;
+    for (face_id i = 1; i < n; ++i)
+      if (closest[i] > closest[fid]) fid = i;
+    return fid;
+  };
+
+  // Start with the face farthest away from an arbitrary face
+  // to not waste the first landmark in the interior.
+  //
+  const face_id start = 0;
+  {
+    const auto field = face_distance_field_from(surface, span(&start, 1));
+    parallel_for(0, n, [&](size_t i) {
+      closest[i] = field.reached(i) ? field.distances[i] : 0;
+    });
+  }
+  auto next = farthest();
+  ranges::fill(closest, infinity);
+
+  // Every distance field is directly scattered into the rows of all faces.
+  //
+  result.distances.resize(n * count);
+  for (size_t k = 0; k < count; ++k) {
+    result.landmarks.push_back(next);
+    const auto field = face_distance_field_from(surface, span(&next, 1));
+    parallel_for(0, n, [&](size_t i) {
+      const auto d = field.distances[i];
+      result.distances[i * count + k] = d;
+      closest[i] = std::min(closest[i], d);
+    });
+    next = farthest();
+    // All faces coincide with landmarks.
+    if (closest[next] == 0) break;
+  }
+
+  // Compact the rows if sampling stopped early.
+  //
+  const auto k = result.landmarks.size();
+  if (k < count) {
+    for (size_t i = 0; i < n; ++i)
+      for (size_t l = 0; l < k; ++l)
+        result.distances[i * k + l] = result.distances[i * count + l];
+    result.distances.resize(n * k);
+  }
+  return result;
+}
+
+}  // namespace nanoreflex
@@ -0,0 +1,59 @@
+#pragma once
+#include <nanoreflex/polyhedral_surface.hpp>
+
+namespace nanoreflex {
+
+/// Landmark faces with precomputed face path distances to all faces.
+/// By the triangle inequality, the distance of two faces is bounded below
+/// by the difference of their distances to any landmark.
+/// Landmarks behind the destination from the view of the source
+/// give tight bounds even where straight-line distances do not,
+/// for example around holes or along strongly curved regions.
+/// Such bounds are consistent and so can be used by A*.
+///
+struct face_landmarks {
+  using face_id = polyhedral_surface::face_id;
+
+  bool empty() const noexcept { return landmarks.empty(); }
+  auto size() const noexcept { return landmarks.size(); }
+  auto face_count() const noexcept {
+    return empty() ? 0 : distances.size() / size();
+  }
+  auto memory_usage() const noexcept -> size_t {
+    return distances.size() * sizeof(float32) +
+           landmarks.size() * sizeof(face_id);
+  }
+
+  /// The distances of one face to all landmarks are stored contiguously.
+  ///
+  auto row(face_id fid) const noexcept {
+    return span(&distances[fid * size()], size());
+  }
+
+  /// Return the largest lower bound of the distance between two faces.
+  /// Landmarks that do not reach both faces are ignored.
+  ///
+  auto lower_bound(span<const float32> x, span<const float32> y) const noexcept
+      -> float32 {
+    float32 result = 0;
+    for (size_t i = 0; i < x.size(); ++i) {
+      if ((x[i] == infinity) || (y[i] == infinity)) continue;
+      result = std::max(result, abs(x[i] - y[i]));
+    }
+    return result;
+  }
+
+  vector<face_id> landmarks{};
+  vector<float32> distances{};
+};
+
+/// Choose the given number of landmarks by farthest-point sampling
+/// and compute their distance tables with parallel distance fields.
+/// Faces not reached by any landmark are preferred.
+/// So, every component gets a landmark as long as there are enough.
+/// The dual graph of the surface needs to be generated before.
+///
+auto face_landmarks_from(const polyhedral_surface& surface, size_t count)
+    -> face_landmarks;
+
+}  // namespace nanoreflex
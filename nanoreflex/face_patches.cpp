@@ -0,0 +1,221 @@
+#include <nanoreflex/face_patches.hpp>
+//
+#include <nanoreflex/indexed_heap.hpp>
+#include <nanoreflex/parallel.hpp>
+
+namespace nanoreflex {
+
+auto face_patches_from(const polyhedral_surface& surface, size_t patch_size)
+    -> face_patches {
+  using face_id = face_patches::face_id;
+  using patch_id = face_patches::patch_id;
+  constexpr auto invalid = polyhedral_surface::invalid;
+  const auto n = surface.faces.size();
+  patch_size = std::max(patch_size, size_t(1));
+
+  face_patches result{};
+  result.patches.assign(n, invalid);
+
+  // Breadth-first growth keeps patches compact
+  // and every patch is connected by construction.
+  // New patches are seeded at the boundary of the previous ones.
+  // Seeding by face order instead would leave thin remnants between them.
+  //
+  vector<uint32> queue{};
+  vector<uint32> seeds{};
+  size_t next = 0;
+  const auto next_seed = [&] {
+    while (!seeds.empty()) {
+      const auto fid = seeds.back();
+      seeds.pop_back();
+      if (result.patches[fid] == invalid) return fid;
+    }
+    while ((next < n) && (result.patches[next] != invalid)) ++next;
+    return uint32(next);
+  };
+  vector<uint32> sizes{};
+  for (auto seed = next_seed(); seed < n; seed = next_seed()) {
+    const auto p = patch_id(sizes.size());
+    queue.assign(1, seed);
+    result.patches[seed] = p;
+    for (size_t i = 0; i < queue.size(); ++i) {
+      for (auto a : surface.face_adjacencies[queue[i]]) {
+        if (a == invalid) continue;
+        const auto neighbor = a >> 2;
+        if (result.patches[neighbor] != invalid) continue;
+        if (queue.size() >= patch_size) {
+          seeds.push_back(neighbor);
+          continue;
+        }
+        result.patches[neighbor] = p;
+        queue.push_back(neighbor);
+      }
+    }
+    sizes.push_back(queue.size());
+  }
+
+  // Remnants still appear where patches enclose a few faces.
+  // Small patches are dissolved into their neighbors
+  // by a breadth-first search starting from all remaining patches.
+  // Small patches without large neighbors, like small components, are kept.
+  //
+  const auto small = [&](patch_id p) { return 4 * sizes[p] < patch_size; };
+  vector<bool> dissolved(sizes.size(), false);
+  for (uint32 fid = 0; fid < n; ++fid) {
+    const auto p = result.patches[fid];
+    if (!small(p)) continue;
+    for (auto a : surface.face_adjacencies[fid])
+      if ((a != invalid) && !small(result.patches[a >> 2])) dissolved[p] = true;
+  }
+  queue.clear();
+  for (uint32 fid = 0; fid < n; ++fid) {
+    if (dissolved[result.patches[fid]])
+      result.patches[fid] = invalid;
+    else
+      queue.push_back(fid);
+  }
+  for (size_t i = 0; i < queue.size(); ++i) {
+    const auto fid = queue[i];
+    for (auto a : surface.face_adjacencies[fid]) {
+      if (a == invalid) continue;
+      const auto neighbor = a >> 2;
+      if (result.patches[neighbor] != invalid) continue;
+      result.patches[neighbor] = result.patches[fid];
+      queue.push_back(neighbor);
+    }
+  }
+
+  // Compact the patch IDs and sort the faces by patches.
+  //
+  vector<patch_id> ids(sizes.size(), invalid);
+  patch_id m = 0;
+  for (patch_id p = 0; p < sizes.size(); ++p)
+    if (!dissolved[p]) ids[p] = m++;
+  vector<uint32> face_offsets(m + 1, 0);
+  for (auto& p : result.patches) {
+    p = ids[p];
+    ++face_offsets[p + 1];
+  }
+  for (size_t p = 0; p < m; ++p) face_offsets[p + 1] += face_offsets[p];
+  vector<face_id> faces(n);
+  {
+    auto positions = face_offsets;
+    for (uint32 fid = 0; fid < n; ++fid)
+      faces[positions[result.patches[fid]]++] = fid;
+  }
+
+  // Every patch is represented by the face closest to its mean barycenter.
+  //
+  result.center_faces.resize(m);
+  result.centers.resize(m);
+  parallel_for(0, m, [&](size_t p) {
+    const auto patch_faces = span(faces.data() + face_offsets[p],
+                                  face_offsets[p + 1] - face_offsets[p]);
+    vec3 mean{};
+    for (auto fid : patch_faces) mean += surface.face_barycenters[fid];
+    mean /= float32(patch_faces.size());
+    auto center = patch_faces[0];
+    for (auto fid : patch_faces)
+      if (distance(surface.face_barycenters[fid], mean) <
+          distance(surface.face_barycenters[center], mean))
+        center = fid;
+    result.center_faces[p] = center;
+    result.centers[p] = surface.face_barycenters[center];
+  });
+
+  // Collect all distinct patch adjacencies.
+  //
+  vector<pair<patch_id, patch_id>> edges{};
+  for (uint32 fid = 0; fid < n; ++fid) {
+    const auto p = result.patches[fid];
+    for (auto a : surface.face_adjacencies[fid]) {
+      if (a == invalid) continue;
+      const auto q = result.patches[a >> 2];
+      if (p != q) edges.push_back({p, q});
+    }
+  }
+  ranges::sort(edges);
+  edges.erase(unique(begin(edges), end(edges)), end(edges));
+
+  result.offsets.assign(m + 1, 0);
+  for (const auto& [p, q] : edges) ++result.offsets[p + 1];
+  for (size_t p = 0; p < m; ++p) result.offsets[p + 1] += result.offsets[p];
+  result.adjacencies.reserve(edges.size());
+  for (const auto& [p, q] : edges) result.adjacencies.push_back(q);
+
+  // Straight-line distances of patch centers underestimate
+  // the face path distances depending on the direction
+  // and would lead the coarse search to other routes than the fine one.
+  // Instead, the weights are face path distances of the center faces
+  // restricted to the patch and its neighbors.
+  // Then straight-line distances remain lower bounds for the coarse A*.
+  // Searches are confined to a patch and its neighbors.
+  // Their faces are indexed locally by the patch order of all faces.
+  // So, every worker only needs memory for the largest such region.
+  //
+  vector<uint32> ranks(n);
+  parallel_for(0, n, [&](size_t i) { ranks[faces[i]] = i; });
+  result.distances.resize(result.adjacencies.size());
+  const auto grain = std::max(size_t(1), m / (4 * thread_count()));
+  parallel_for_chunks(
+      0, m,
+      [&](size_t first, size_t last) {
+        vector<face_id> region{};
+        vector<uint32> region_offsets{};
+        vector<float32> distances{};
+        indexed_heap<4> queue{};
+        for (auto p = patch_id(first); p < last; ++p) {
+          const auto neighbors = result.neighbors(p);
+          region_offsets.assign(1, 0);
+          region.clear();
+          const auto add_patch = [&](patch_id q) {
+            region.insert(end(region), begin(faces) + face_offsets[q],
+                          begin(faces) + face_offsets[q + 1]);
+            region_offsets.push_back(region.size());
+          };
+          add_patch(p);
+          for (auto q : neighbors) add_patch(q);
+          const auto local = [&](face_id fid) {
+            const auto q = result.patches[fid];
+            size_t i = 0;
+            if (q != p) {
+              const auto it = ranges::lower_bound(neighbors, q);
+              if ((it == end(neighbors)) || (*it != q)) return invalid;
+              i = 1 + (it - begin(neighbors));
+            }
+            return uint32(region_offsets[i] + ranks[fid] - face_offsets[q]);
+          };
+
+          size_t remaining = neighbors.size();
+          const auto src = result.center_faces[p];
+          distances.assign(region.size(), infinity);
+          distances[local(src)] = 0;
+          queue.resize(region.size());
+          queue.push_or_decrease(local(src), 0);
+          while (!queue.empty() && (remaining > 0)) {
+            const auto x = queue.pop().index;
+            const auto fid = region[x];
+            if (result.center_faces[result.patches[fid]] == fid && fid != src)
+              --remaining;
+            for (size_t i = 0; i < 3; ++i) {
+              const auto a = surface.face_adjacencies[fid][i];
+              if (a == invalid) continue;
+              const auto y = local(a >> 2);
+              if (y == invalid) continue;
+              const auto d =
+                  distances[x] + surface.face_adjacency_weights[fid][i];
+              if (d >= distances[y]) continue;
+              distances[y] = d;
+              queue.push_or_decrease(y, d);
+            }
+          }
+          for (size_t i = 0; i < neighbors.size(); ++i)
+            result.distances[result.offsets[p] + i] =
+                distances[local(result.center_faces[neighbors[i]])];
+        }
+      },
+      grain);
+  return result;
+}
+
+}  // namespace nanoreflex
@@ -0,0 +1,54 @@
+#pragma once
+#include <nanoreflex/polyhedral_surface.hpp>
+
+namespace nanoreflex {
+
+/// Coarse level of the dual graph given by connected patches of faces.
+/// Every patch is represented by the face closest to its mean barycenter
+/// and two patches are connected if any of their faces are adjacent.
+/// Edges are weighted by the face path distance of both center faces.
+/// A shortest path in this small graph gives a corridor of patches
+/// to which a search on the fine level can be restricted.
+///
+struct face_patches {
+  using face_id = polyhedral_surface::face_id;
+  using patch_id = uint32;
+
+  auto size() const noexcept { return centers.size(); }
+  auto patch(face_id fid) const noexcept { return patches[fid]; }
+
+  /// Neighbors and edge weights of a patch in the coarse graph.
+  ///
+  auto neighbors(patch_id p) const noexcept {
+    return span(adjacencies.data() + offsets[p], offsets[p + 1] - offsets[p]);
+  }
+  auto weights(patch_id p) const noexcept {
+    return span(distances.data() + offsets[p], offsets[p + 1] - offsets[p]);
+  }
+
+  auto memory_usage() const noexcept -> size_t {
+    return patches.size() * sizeof(patch_id) +
+           centers.size() * (sizeof(vec3) + sizeof(face_id)) +
+           offsets.size() * sizeof(uint32) +
+           adjacencies.size() * (sizeof(patch_id) + sizeof(float32));
+  }
+
+  // Patch of every face.
+  polyhedral_surface::face_map<patch_id> patches{};
+  vector<face_id> center_faces{};
+  vector<vec3> centers{};
+  // Coarse graph in compressed sparse row format.
+  vector<uint32> offsets{};
+  vector<patch_id> adjacencies{};
+  vector<float32> distances{};
+};
+
+/// Grow patches of at most 'patch_size' faces by breadth-first search
+/// over the face adjacencies and build the coarse graph.
+/// Small remnants are merged into their neighbors.
+/// The dual graph of the surface needs to be generated before.
+///
+auto face_patches_from(const polyhedral_surface& surface,
+                       size_t patch_size = 256) -> face_patches;
+
+}  // namespace nanoreflex
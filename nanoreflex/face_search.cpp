@@ -0,0 +1,253 @@
+#include <nanoreflex/face_search.hpp>
+
+namespace nanoreflex {
+
+void face_search::start(size_t face_count) {
+  // Only a different surface size requires new memory.
+  if (forward.size() != face_count) {
+    forward.assign(face_count, {});
+    backward.clear();
+    queue.resize(face_count);
+    backward_queue.resize(0);
+    generation = 0;
+  }
+  queue.clear();
+  backward_queue.clear();
+
+  // After an overflow, old stamps could be mistaken as current.
+  if (++generation == 0) {
+    ranges::fill(forward, face_state{});
+    ranges::fill(backward, face_state{});
+    generation = 1;
+  }
+  expanded = 0;
+}
+
+auto face_search::lower_bound(const polyhedral_surface& surface,
+                              face_id fid,
+                              face_id dst) const noexcept -> float32 {
+  const auto& barycenters = surface.face_barycenters;
+  const auto bound = distance(barycenters[fid], barycenters[dst]);
+  if (!landmarks || landmarks->face_count() != surface.faces.size())
+    return bound;
+  return std::max(bound,
+                  landmarks->lower_bound(landmarks->row(fid),
+                                         landmarks->row(dst)));
+}
+
+void face_search::run(const polyhedral_surface& surface,
+                      face_id src,
+                      face_id dst,
+                      strategy s) {
+  start(surface.faces.size());
+  source = src;
+
+  // Faces of different components are never connected.
+  if (dst != invalid && surface.component(src) != surface.component(dst))
+    return;
+
+  // Without a destination, there is nothing to direct the search to.
+  if (dst == invalid || s == strategy::dijkstra)
+    run_forward(surface, src, dst, false);
+  else if (s == strategy::bidirectional)
+    run_bidirectional(surface, src, dst);
+  else if (s == strategy::hierarchical &&
+           mark_corridor(surface, src, dst)) {
+    run_forward(surface, src, dst, true, true);
+    if (reached(dst)) return;
+    // The corridor is not connected on the fine level.
+    start(surface.faces.size());
+    run_forward(surface, src, dst, true);
+  } else
+    run_forward(surface, src, dst, true);
+}
+
+bool face_search::mark_corridor(const polyhedral_surface& surface,
+                                face_id src,
+                                face_id dst) {
+  using patch_id = face_patches::patch_id;
+  if (!patches || patches->patches.size() != surface.faces.size())
+    return false;
+
+  // A* on the coarse graph whose size only is a fraction of the surface.
+  // So, the state is simply allocated for every query.
+  //
+  const auto m = patches->size();
+  const auto s = patches->patch(src);
+  const auto t = patches->patch(dst);
+  const auto& centers = patches->centers;
+  vector<float32> distances(m, infinity);
+  vector<patch_id> previous(m, invalid);
+  vector<bool> done(m, false);
+  indexed_heap<4> coarse_queue(m);
+  distances[s] = 0;
+  previous[s] = s;
+  coarse_queue.push_or_decrease(s, 0);
+  while (!coarse_queue.empty()) {
+    const auto p = coarse_queue.pop().index;
+    done[p] = true;
+    if (p == t) break;
+    const auto neighbors = patches->neighbors(p);
+    const auto weights = patches->weights(p);
+    for (size_t i = 0; i < neighbors.size(); ++i) {
+      const auto q = neighbors[i];
+      if (done[q]) continue;
+      const auto d = distances[p] + weights[i];
+      if (d >= distances[q]) continue;
+      distances[q] = d;
+      previous[q] = p;
+      coarse_queue.push_or_decrease(q, d + distance(centers[q], centers[t]));
+    }
+  }
+  if (!done[t]) return false;
+
+  // Widen the coarse path by all neighboring patches
+  // to give the fine search some space to straighten.
+  //
+  corridor.assign(m, false);
+  for (auto p = t;; p = previous[p]) {
+    corridor[p] = true;
+    for (auto q : patches->neighbors(p)) corridor[q] = true;
+    if (p == s) break;
+  }
+  return true;
+}
+
+void face_search::run_forward(const polyhedral_surface& surface,
+                              face_id src,
+                              face_id dst,
+                              bool guided,
+                              bool restricted) {
+  const auto& weights = surface.face_adjacency_weights;
+  const auto bound = [&](face_id fid) {
+    return guided ? lower_bound(surface, fid, dst) : 0.0f;
+  };
+
+  auto& s = state(forward, src);
+  s.distance = 0;
+  s.previous = src << 2;
+  queue.push_or_decrease(src, 0);
+
+  while (!queue.empty()) {
+    const auto current = queue.pop().index;
+    auto& c = forward[current];
+    c.settled = true;
+    ++expanded;
+    if (current == dst) break;
+
+    for (uint32 i = 0; i < 3; ++i) {
+      const auto n = surface.face_adjacencies[current][i];
+      if (n == invalid) continue;
+      const auto neighbor = n >> 2;
+      if (restricted && !corridor[patches->patch(neighbor)]) continue;
+      auto& x = state(forward, neighbor);
+      if (x.settled) continue;
+
+      const auto d = c.distance + weights[current][i];
+      if (d >= x.distance) continue;
+
+      x.distance = d;
+      x.previous = (current << 2) | i;
+      queue.push_or_decrease(neighbor, d + bound(neighbor));
+    }
+  }
+}
+
+void face_search::run_bidirectional(const polyhedral_surface& surface,
+                                    face_id src,
+                                    face_id dst) {
+  const auto n = surface.faces.size();
+  if (backward.size() != n) {
+    backward.assign(n, {});
+    backward_queue.resize(n);
+  }
+
+  // The averaged potential is a consistent lower bound for both
+  // directions at once. With it, the search can stop as soon as
+  // the smallest keys of both queues add up to the best known length.
+  //
+  const auto& weights = surface.face_adjacency_weights;
+  const auto potential = [&](face_id fid) {
+    return 0.5f * (lower_bound(surface, fid, dst) -
+                   lower_bound(surface, fid, src));
+  };
+
+  auto& first = state(forward, src);
+  first.distance = 0;
+  first.previous = src << 2;
+  if (src == dst) {
+    first.settled = true;
+    return;
+  }
+  queue.push_or_decrease(src, potential(src));
+  auto& last = state(backward, dst);
+  last.distance = 0;
+  last.previous = dst << 2;
+  backward_queue.push_or_decrease(dst, -potential(dst));
+
+  // Best known path length and its connecting adjacency
+  // given by the forward face and the location in it.
+  auto best = infinity;
+  uint32 meeting = invalid;
+
+  const auto expand = [&](bool is_forward) {
+    auto& q = is_forward ? queue : backward_queue;
+    auto& states = is_forward ? forward : backward;
+    const auto& other = is_forward ? backward : forward;
+    const auto sign = is_forward ? 1.0f : -1.0f;
+
+    const auto current = q.pop().index;
+    auto& c = states[current];
+    c.settled = true;
+    ++expanded;
+
+    for (uint32 i = 0; i < 3; ++i) {
+      const auto a = surface.face_adjacencies[current][i];
+      if (a == invalid) continue;
+      const auto neighbor = a >> 2;
+      const auto d = c.distance + weights[current][i];
+
+      // Check for a shorter path through this adjacency.
+      if (stamped(other, neighbor) && d + other[neighbor].distance < best) {
+        best = d + other[neighbor].distance;
+        meeting = is_forward ? ((current << 2) | i) : a;
+      }
+
+      auto& y = state(states, neighbor);
+      if (y.settled || d >= y.distance) continue;
+      y.distance = d;
+      y.previous = (current << 2) | i;
+      q.push_or_decrease(neighbor, d + sign * potential(neighbor));
+    }
+  };
+
+  while (!queue.empty() && !backward_queue.empty()) {
+    if (queue.top().key + backward_queue.top().key >= best) break;
+    expand(queue.top().key <= backward_queue.top().key);
+  }
+
+  // The destination is not reachable.
+  if (meeting == invalid) return;
+
+  // Mark the forward part of the path and append the backward part
+  // by reversing its predecessor encoding.
+  //
+  for (auto f = meeting >> 2; f != src; f = forward[f].previous >> 2)
+    forward[f].settled = true;
+  forward[src].settled = true;
+  auto u = meeting >> 2;
+  auto loc = meeting & 0b11;
+  while (true) {
+    const auto v = surface.face_adjacencies[u][loc] >> 2;
+    const auto next = backward[v].previous;
+    auto& x = state(forward, v);
+    x.previous = (u << 2) | loc;
+    x.distance = best - backward[v].distance;
+    x.settled = true;
+    if (v == dst) break;
+    loc = surface.face_adjacencies[next >> 2][next & 0b11] & 0b11;
+    u = v;
+  }
+}
+
+}  // namespace nanoreflex
@@ -0,0 +1,135 @@
+#pragma once
+#include <nanoreflex/face_landmarks.hpp>
+#include <nanoreflex/face_patches.hpp>
+#include <nanoreflex/indexed_heap.hpp>
+#include <nanoreflex/polyhedral_surface.hpp>
+
+namespace nanoreflex {
+
+/// Shortest path search on the dual graph of a polyhedral surface.
+/// Faces are the nodes and adjacent faces are connected by edges
+/// weighted with the distance of their barycenters.
+/// The dual graph of the surface needs to be generated before.
+/// The search state is kept after a run to extract paths afterwards.
+///
+/// The object is meant to be kept alive as a workspace for many queries.
+/// Every run starts a new generation and the state of a face is only valid
+/// if it has been stamped with the current generation.
+/// So, no state needs to be reset between runs
+/// and a query only touches the faces it actually explores.
+///
+struct face_search {
+  using face_id = polyhedral_surface::face_id;
+  static constexpr uint32 invalid = polyhedral_surface::invalid;
+
+  /// The straight-line distance of two barycenters is a lower bound
+  /// for the length of every face path connecting them.
+  /// A* uses this bound to direct the search towards the destination.
+  /// The bidirectional variant runs A* from both ends
+  /// with averaged bounds and stops when both searches have met
+  /// on a path that cannot be improved anymore.
+  /// All strategies return paths of the same length.
+  /// If landmarks for the surface are given,
+  /// A* additionally uses their triangle inequality bounds.
+  ///
+  /// The hierarchical strategy needs patches of the surface.
+  /// It first searches a path of patches in their coarse graph
+  /// and then restricts A* to the corridor of the patches on this path
+  /// and their direct neighbors.
+  /// Its paths are only shortest inside the corridor.
+  /// If the corridor does not connect both faces,
+  /// an unrestricted A* is used instead.
+  ///
+  enum class strategy { dijkstra, astar, bidirectional, hierarchical };
+
+  struct face_state {
+    uint32 generation = 0;
+    bool settled = false;
+    float32 distance = infinity;
+    uint32 previous = invalid;
+  };
+
+  /// Search a shortest path from 'src' to 'dst'
+  /// and stop as soon as its length is known.
+  /// If 'dst' lies in another component, nothing is searched at all.
+  /// If 'dst' is invalid, all faces reachable from 'src' are settled.
+  ///
+  void run(const polyhedral_surface& surface,
+           face_id src,
+           face_id dst,
+           strategy s);
+  void run(const polyhedral_surface& surface, face_id src, face_id dst) {
+    run(surface, src, dst, default_strategy);
+  }
+
+  /// After a run, every face on the found path and all faces settled
+  /// by the forward search have been reached.
+  ///
+  bool reached(face_id fid) const noexcept {
+    return stamped(forward, fid) && forward[fid].settled;
+  }
+
+  /// Length of the shortest known path from the source to the given face.
+  ///
+  auto path_length(face_id fid) const noexcept -> float32 {
+    return stamped(forward, fid) ? forward[fid].distance : infinity;
+  }
+
+  /// For every reached face, return the face it has been reached from
+  /// together with the location of the adjacency in this previous face
+  /// by '(pfid << 2) | loc'. The source is its own predecessor.
+  ///
+  auto predecessor(face_id fid) const noexcept -> uint32 {
+    assert(stamped(forward, fid));
+    return forward[fid].previous;
+  }
+
+  strategy default_strategy = strategy::astar;
+  // Optional landmarks to tighten the lower bounds of A*.
+  const face_landmarks* landmarks = nullptr;
+  // Optional patches for the hierarchical strategy
+  // and the marked corridor of patches of the last run.
+  const face_patches* patches = nullptr;
+  vector<bool> corridor{};
+
+  face_id source = invalid;
+  uint32 generation = 0;
+  vector<face_state> forward{};
+  indexed_heap<4> queue{};
+  // State of the backward search for the bidirectional strategy.
+  vector<face_state> backward{};
+  indexed_heap<4> backward_queue{};
+  // Number of faces settled by the last run in both directions.
+  size_t expanded = 0;
+
+ private:
+  bool stamped(const vector<face_state>& states, face_id fid) const noexcept {
+    return states[fid].generation == generation;
+  }
+  auto state(vector<face_state>& states, face_id fid) noexcept
+      -> face_state& {
+    auto& s = states[fid];
+    if (s.generation != generation) s = {.generation = generation};
+    return s;
+  }
+
+  void start(size_t face_count);
+  /// Return a consistent lower bound for the distance of two faces.
+  ///
+  auto lower_bound(const polyhedral_surface& surface,
+                   face_id fid,
+                   face_id dst) const noexcept -> float32;
+  void run_forward(const polyhedral_surface& surface,
+                   face_id src,
+                   face_id dst,
+                   bool guided,
+                   bool restricted = false);
+  bool mark_corridor(const polyhedral_surface& surface,
+                     face_id src,
+                     face_id dst);
+  void run_bidirectional(const polyhedral_surface& surface,
+                         face_id src,
+                         face_id dst);
+};
+
+}  // namespace nanoreflex
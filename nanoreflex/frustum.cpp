@@ -0,0 +1,131 @@
+#include <nanoreflex/frustum.hpp>
+#include <nanoreflex/parallel.hpp>
+#include <nanoreflex/ray_tracer.hpp>
+
+namespace nanoreflex {
+
+namespace {
+
+// A subtree of a bottom-level hierarchy that is left to be processed.
+// Leaves are given by a non-zero primitive count.
+// Subtrees completely inside the frustum need no further tests.
+//
+struct culling_task {
+  const wide_bvh* tree;
+  wide_bvh::index_type index;
+  uint32 count;
+  bool inside;
+};
+
+void expand(const frustum& volume,
+            const culling_task& task,
+            auto&& push) noexcept {
+  const auto& node = task.tree->nodes[task.index];
+  for (size_t i = 0; i < wide_bvh::width; ++i) {
+    if (node.empty(i)) continue;
+    const auto relation =
+        task.inside ? frustum::relation::inside : volume.classify(node.box(i));
+    if (relation == frustum::relation::outside) continue;
+    push(culling_task{task.tree, node.child[i], node.count[i],
+                      relation == frustum::relation::inside});
+  }
+}
+
+void gather(const frustum& volume,
+            const polyhedral_surface& surface,
+            const culling_task& root,
+            vector<uint32>& result) {
+  const auto inside = [&](uint32 fid) {
+    const auto& f = surface.faces[fid];
+    return volume.contains(surface.position(f[0])) &&
+           volume.contains(surface.position(f[1])) &&
+           volume.contains(surface.position(f[2]));
+  };
+
+  vector<culling_task> stack{root};
+  while (!stack.empty()) {
+    const auto task = stack.back();
+    stack.pop_back();
+    if (task.count == 0) {
+      expand(volume, task, [&](const culling_task& t) { stack.push_back(t); });
+      continue;
+    }
+    for (auto fid : span(&task.tree->primitives[task.index], task.count))
+      if (task.inside || inside(fid)) result.push_back(fid);
+  }
+}
+
+}  // namespace
+
+auto faces_inside(const frustum& volume,
+                  const polyhedral_surface& surface,
+                  const surface_bvh& tree) -> vector<uint32> {
+  using relation = frustum::relation;
+
+  // Cull whole components by using the top level.
+  //
+  const auto accept = [&](const aabb3& box) {
+    return volume.classify(box) != relation::outside;
+  };
+  vector<culling_task> tasks{};
+  for_each_leaf(tree.top, accept, [&](auto cids) {
+    for (auto cid : cids) {
+      if (!tree.visible(cid)) continue;
+      const auto& component = tree.components[cid];
+      const auto r = volume.classify(component.box());
+      if (r == relation::outside) continue;
+      tasks.push_back({&component, 0, 0, r == relation::inside});
+    }
+  });
+
+  // A few large components would not keep all threads busy.
+  // So, split the work into subtrees until there are enough tasks.
+  //
+  for (size_t level = 0; level < 3 && tasks.size() < 4 * thread_count();
+       ++level) {
+    vector<culling_task> subtasks{};
+    for (const auto& task : tasks) {
+      if (task.count != 0)
+        subtasks.push_back(task);
+      else
+        expand(volume, task,
+               [&](const culling_task& t) { subtasks.push_back(t); });
+    }
+    tasks.swap(subtasks);
+  }
+
+  vector<vector<uint32>> parts(tasks.size());
+  parallel_for(
+      0, tasks.size(),
+      [&](size_t i) { gather(volume, surface, tasks[i], parts[i]); }, 1);
+
+  vector<uint32> result{};
+  size_t size = 0;
+  for (const auto& part : parts) size += part.size();
+  result.reserve(size);
+  for (const auto& part : parts)
+    result.insert(end(result), begin(part), end(part));
+  return result;
+}
+
+void remove_occluded_faces(const vec3& eye,
+                           vector<uint32>& faces,
+                           const polyhedral_surface& surface,
+                           const surface_bvh& tree) {
+  vector<uint8> visible(faces.size());
+  parallel_for(
+      0, faces.size(),
+      [&](size_t i) {
+        const auto fid = faces[i];
+        const auto p = surface.position(fid, 1 / 3.0f, 1 / 3.0f);
+        const auto hit = intersection({eye, normalize(p - eye)}, surface, tree);
+        visible[i] = hit && (hit.f == fid);
+      },
+      256);
+  size_t n = 0;
+  for (size_t i = 0; i < faces.size(); ++i)
+    if (visible[i]) faces[n++] = faces[i];
+  faces.resize(n);
+}
+
+}  // namespace nanoreflex
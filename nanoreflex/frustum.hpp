@@ -0,0 +1,62 @@
+#pragma once
+#include <nanoreflex/surface_bvh.hpp>
+
+namespace nanoreflex {
+
+/// Convex volume bounded by planes, as seen by a camera
+/// through a rectangle of the screen.
+/// Every plane is given by its inward-pointing normal 'n' and offset 'd'
+/// such that a point 'x' lies inside if 'dot(n, x) + d >= 0'.
+///
+struct frustum {
+  struct plane {
+    vec3 normal;
+    float offset;
+  };
+
+  enum class relation { outside, intersecting, inside };
+
+  bool contains(const vec3& p) const noexcept {
+    for (const auto& [n, d] : planes)
+      if (dot(n, p) + d < 0) return false;
+    return true;
+  }
+
+  /// Conservative classification of a box
+  /// by only looking at its two extremal corners per plane.
+  ///
+  auto classify(const aabb3& box) const noexcept -> relation {
+    auto result = relation::inside;
+    for (const auto& [n, d] : planes) {
+      vec3 outer{}, inner{};
+      for (int k = 0; k < 3; ++k) {
+        outer[k] = (n[k] >= 0) ? box._max[k] : box._min[k];
+        inner[k] = (n[k] >= 0) ? box._min[k] : box._max[k];
+      }
+      if (dot(n, outer) + d < 0) return relation::outside;
+      if (dot(n, inner) + d < 0) result = relation::intersecting;
+    }
+    return result;
+  }
+
+  vector<plane> planes{};
+};
+
+/// Return all faces of visible components whose three vertices
+/// lie inside the frustum.
+/// Components and bottom-level subtrees are culled hierarchically
+/// and all components are processed in parallel.
+///
+auto faces_inside(const frustum& volume,
+                  const polyhedral_surface& surface,
+                  const surface_bvh& tree) -> vector<uint32>;
+
+/// Remove all faces whose barycenter cannot be seen from the given eye
+/// because other faces occlude them.
+///
+void remove_occluded_faces(const vec3& eye,
+                           vector<uint32>& faces,
+                           const polyhedral_surface& surface,
+                           const surface_bvh& tree);
+
+}  // namespace nanoreflex
@@ -0,0 +1,262 @@
+#include <nanoreflex/heat_geodesics.hpp>
+//
+#include <nanoreflex/parallel.hpp>
+
+namespace nanoreflex {
+
+namespace {
+
+constexpr auto invalid = polyhedral_surface::invalid;
+
+/// Fill-reducing ordering by geometric nested dissection.
+/// The vertices are recursively split at the median of their longest axis.
+/// Vertices of the lower half with neighbors in the upper half
+/// form a separator that is eliminated after both halves.
+/// So, the halves stay decoupled during the factorization
+/// and for surface meshes the fill-in only grows like 'n log n'.
+///
+auto nested_dissection_ordering(const sparse_matrix& a,
+                                const vector<vec3>& positions)
+    -> vector<sparse_matrix::index_type> {
+  using index_type = sparse_matrix::index_type;
+  constexpr size_t leaf_size = 64;
+
+  const auto n = a.size();
+  vector<index_type> ids(n);
+  iota(begin(ids), end(ids), index_type(0));
+  vector<index_type> order{};
+  order.reserve(n);
+  vector<bool> upper(n, false);
+
+  const auto dissect = [&](auto&& dissect, size_t first, size_t last) -> void {
+    const auto count = last - first;
+    if (count <= leaf_size) {
+      order.insert(end(order), begin(ids) + first, begin(ids) + last);
+      return;
+    }
+
+    auto box = aabb_from(positions[ids[first]]);
+    for (auto i = first + 1; i < last; ++i)
+      box = aabb(box, positions[ids[i]]);
+    const auto extent = box._max - box._min;
+    int axis = 0;
+    if (extent[1] > extent[axis]) axis = 1;
+    if (extent[2] > extent[axis]) axis = 2;
+
+    const auto middle = first + count / 2;
+    nth_element(begin(ids) + first, begin(ids) + middle, begin(ids) + last,
+                [&](index_type i, index_type j) {
+                  return positions[i][axis] < positions[j][axis];
+                });
+
+    for (auto i = middle; i < last; ++i) upper[ids[i]] = true;
+    const auto separator = partition(
+        begin(ids) + first, begin(ids) + middle, [&](index_type v) {
+          for (auto p = a.column_offsets[v]; p < a.column_offsets[v + 1]; ++p)
+            if (upper[a.rows[p]]) return false;
+          return true;
+        });
+    for (auto i = middle; i < last; ++i) upper[ids[i]] = false;
+
+    const auto s = size_t(separator - begin(ids));
+    dissect(dissect, first, s);
+    dissect(dissect, middle, last);
+    order.insert(end(order), begin(ids) + s, begin(ids) + middle);
+  };
+  dissect(dissect, 0, n);
+  return order;
+}
+
+}  // namespace
+
+auto heat_geodesics_from(const polyhedral_surface& surface) -> heat_geodesics {
+  using vertex_id = heat_geodesics::vertex_id;
+  heat_geodesics result{};
+  const auto n = surface.topological_vertex_count();
+
+  result.positions.resize(n);
+  for (vertex_id v = 0; v < n; ++v)
+    result.positions[v] =
+        surface.position(surface.topological_vertex_vertex_ids(v)[0]);
+
+  result.faces.resize(surface.faces.size());
+  result.components.assign(n, invalid);
+  for (size_t fid = 0; fid < surface.faces.size(); ++fid)
+    for (size_t i = 0; i < 3; ++i) {
+      const auto v = surface.topological_vertex(surface.faces[fid][i]);
+      result.faces[fid][i] = v;
+      result.components[v] = surface.component(fid);
+    }
+
+  // Compute the cotangents of all corners, the lumped vertex masses,
+  // and the mean edge length which defines the diffusion time.
+  //
+  const auto& p = result.positions;
+  result.cotangents.resize(result.faces.size());
+  vector<float64> masses(n, 0);
+  float64 edge_lengths = 0;
+  for (size_t fid = 0; fid < result.faces.size(); ++fid) {
+    const auto [i, j, k] = result.faces[fid];
+    const auto area2 = length(cross(p[j] - p[i], p[k] - p[i]));
+    const auto cotangent = [&](vertex_id x, vertex_id y, vertex_id z) {
+      return (area2 == 0) ? 0.0f : dot(p[y] - p[x], p[z] - p[x]) / area2;
+    };
+    result.cotangents[fid] = {cotangent(i, j, k), cotangent(j, k, i),
+                              cotangent(k, i, j)};
+    for (auto v : {i, j, k}) masses[v] += area2 / 6.0;
+    edge_lengths +=
+        distance(p[i], p[j]) + distance(p[j], p[k]) + distance(p[k], p[i]);
+  }
+  const auto mean_edge_length =
+      result.faces.empty() ? 1.0 : edge_lengths / (3 * result.faces.size());
+  result.time = mean_edge_length * mean_edge_length;
+
+  // Vertices without any area are decoupled from everything else.
+  for (auto& m : masses)
+    if (m == 0) m = 1;
+
+  // Stiffness matrix entries given by the cotangent weights of edges.
+  //
+  vector<sparse_matrix::triplet> stiffness{};
+  stiffness.reserve(12 * result.faces.size());
+  for (size_t fid = 0; fid < result.faces.size(); ++fid) {
+    const auto& f = result.faces[fid];
+    for (size_t c = 0; c < 3; ++c) {
+      const auto i = f[(c + 1) % 3];
+      const auto j = f[(c + 2) % 3];
+      const auto w = 0.5 * result.cotangents[fid][c];
+      stiffness.push_back({i, j, -w});
+      stiffness.push_back({j, i, -w});
+      stiffness.push_back({i, i, w});
+      stiffness.push_back({j, j, w});
+    }
+  }
+
+  // The heat system 'M + t K' is positive definite.
+  //
+  auto heat_entries = stiffness;
+  for (auto& e : heat_entries) e.value *= result.time;
+  for (vertex_id v = 0; v < n; ++v) heat_entries.push_back({v, v, masses[v]});
+  const auto heat = sparse_matrix_from(n, std::move(heat_entries));
+
+  // The stiffness matrix is singular with constant functions
+  // on every component in its kernel.
+  // Fixing the value of one vertex per component
+  // by replacing its row and column with the identity
+  // makes it positive definite without changing the solution
+  // for right-hand sides that sum up to zero on every component.
+  //
+  vector<bool> grounded(n, false);
+  {
+    vector<bool> seen(surface.component_count(), false);
+    for (vertex_id v = 0; v < n; ++v) {
+      const auto c = result.components[v];
+      if (c != invalid && seen[c]) continue;
+      if (c != invalid) seen[c] = true;
+      grounded[v] = true;
+      result.grounded.push_back(v);
+    }
+  }
+  erase_if(stiffness, [&](const auto& e) {
+    return grounded[e.row] || grounded[e.column];
+  });
+  for (auto v : result.grounded) stiffness.push_back({v, v, 1});
+  const auto poisson = sparse_matrix_from(n, std::move(stiffness));
+
+  // Both matrices share the pattern of the mesh graph.
+  // So, one ordering serves both factorizations.
+  //
+  auto order = nested_dissection_ordering(heat, result.positions);
+  result.heat.analyze(heat, order);
+  result.poisson.analyze(poisson, std::move(order));
+  auto heat_factorized = true;
+  auto poisson_factorized = true;
+  parallel_for(
+      0, 2,
+      [&](size_t i) {
+        if (i == 0)
+          heat_factorized = result.heat.factorize(heat);
+        else
+          poisson_factorized = result.poisson.factorize(poisson);
+      },
+      1);
+  if (!heat_factorized || !poisson_factorized)
+    throw runtime_error("Failed to factorize the matrices of the heat method.");
+
+  return result;
+}
+
+auto heat_geodesics::distances(span<const vertex_id> sources) const
+    -> vector<float32> {
+  const auto n = vertex_count();
+
+  // Diffuse heat from the sources.
+  //
+  vector<float64> u(n, 0);
+  for (auto s : sources) u[s] = 1;
+  heat.solve(u);
+
+  // Integrate the divergence of the normalized negative heat gradient
+  // over the dual cell of every vertex.
+  //
+  vector<float64> divergence(n, 0);
+  for (size_t fid = 0; fid < faces.size(); ++fid) {
+    const auto [i, j, k] = faces[fid];
+    // Heat decays exponentially and the gradient direction
+    // does not depend on the scale. So, rescale for single precision.
+    const auto scale = std::max({u[i], u[j], u[k]});
+    if (!(scale > 0)) continue;
+    const auto ui = float32(u[i] / scale);
+    const auto uj = float32(u[j] / scale);
+    const auto uk = float32(u[k] / scale);
+
+    const auto& pi = positions[i];
+    const auto& pj = positions[j];
+    const auto& pk = positions[k];
+    const auto normal = cross(pj - pi, pk - pi);
+    const auto area2 = length(normal);
+    if (area2 == 0) continue;
+    const auto nn = normal / area2;
+    const auto gradient = ui * cross(nn, pk - pj) + uj * cross(nn, pi - pk) +
+                          uk * cross(nn, pj - pi);
+    const auto l = length(gradient);
+    if (l == 0) continue;
+    const auto x = -gradient / l;
+
+    const auto& cot = cotangents[fid];
+    const auto flux = [&](float32 c1, const vec3& e1, float32 c2,
+                          const vec3& e2) {
+      return 0.5 * (c1 * dot(e1, x) + c2 * dot(e2, x));
+    };
+    divergence[i] += flux(cot[2], pj - pi, cot[1], pk - pi);
+    divergence[j] += flux(cot[0], pk - pj, cot[2], pi - pj);
+    divergence[k] += flux(cot[1], pi - pk, cot[0], pj - pk);
+  }
+
+  // Recover the distances by solving 'L phi = div X' with 'L = -K'.
+  // Grounded vertices only fix the constant of their component.
+  //
+  for (auto& d : divergence) d = -d;
+  for (auto v : grounded) divergence[v] = 0;
+  poisson.solve(divergence);
+  const auto& phi = divergence;
+
+  // Shift the potential such that the sources have zero distance.
+  //
+  unordered_map<uint32, float64> offsets{};
+  for (auto s : sources) {
+    const auto [it, inserted] = offsets.try_emplace(components[s], phi[s]);
+    if (!inserted) it->second = std::min(it->second, phi[s]);
+  }
+  vector<float32> result(n, infinity);
+  for (size_t v = 0; v < n; ++v) {
+    if (components[v] == invalid) continue;
+    const auto it = offsets.find(components[v]);
+    if (it == end(offsets)) continue;
+    result[v] = float32(std::max(phi[v] - it->second, 0.0));
+  }
+  for (auto s : sources) result[s] = 0;
+  return result;
+}
+
+}  // namespace nanoreflex
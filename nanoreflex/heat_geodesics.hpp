@@ -0,0 +1,61 @@
+#pragma once
+#include <nanoreflex/polyhedral_surface.hpp>
+#include <nanoreflex/sparse_ldlt.hpp>
+
+namespace nanoreflex {
+
+/// Geodesic distances on the topological vertices of a polyhedral surface
+/// computed by the heat method of Crane, Weischedel, and Wardetzky.
+/// Heat is diffused from the sources for a short time step.
+/// The normalized negative heat gradient then points along geodesics
+/// and its divergence yields the distances by a Poisson equation.
+///
+/// Both linear systems are given by the cotangent Laplacian
+/// and the lumped mass matrix of the mesh.
+/// They are factorized once during construction.
+/// So, every query only costs two pairs of triangular solves.
+///
+struct heat_geodesics {
+  using vertex_id = polyhedral_surface::vertex_id;
+  using face_id = polyhedral_surface::face_id;
+
+  bool empty() const noexcept { return faces.empty(); }
+  auto vertex_count() const noexcept { return positions.size(); }
+
+  auto memory_usage() const noexcept -> size_t {
+    return heat.memory_usage() + poisson.memory_usage() +
+           faces.size() * (sizeof(array<vertex_id, 3>) + sizeof(vec3)) +
+           positions.size() * (sizeof(vec3) + sizeof(uint32)) +
+           grounded.size() * sizeof(vertex_id);
+  }
+
+  /// Return the geodesic distance of every topological vertex
+  /// to its closest topological source vertex.
+  /// Vertices of components without any source have infinite distance.
+  ///
+  auto distances(span<const vertex_id> sources) const -> vector<float32>;
+
+  // Faces given by topological vertex IDs.
+  vector<array<vertex_id, 3>> faces{};
+  // Cotangents of the interior angles for all face corners.
+  vector<vec3> cotangents{};
+  vector<vec3> positions{};
+  // Component of every topological vertex.
+  vector<uint32> components{};
+  // One vertex per component whose potential is fixed to zero.
+  vector<vertex_id> grounded{};
+  // Diffusion time given by the squared mean edge length.
+  float64 time{};
+  // Factorizations of the heat system 'M + t K' and the grounded 'K'
+  // with the positive semidefinite stiffness matrix 'K'
+  // and the lumped mass matrix 'M'.
+  sparse_ldlt heat{};
+  sparse_ldlt poisson{};
+};
+
+/// Assemble and factorize all matrices of the heat method.
+/// The topological structure of the surface needs to be generated before.
+///
+auto heat_geodesics_from(const polyhedral_surface& surface) -> heat_geodesics;
+
+}  // namespace nanoreflex
@@ -0,0 +1,115 @@
+#pragma once
+#include <nanoreflex/utility.hpp>
+
+namespace nanoreflex {
+
+/// Min-heap with the given arity over the indices [0, n) with float keys.
+/// Every index is contained at most once and its heap position is stored.
+/// So, the key of a contained index can be decreased in place
+/// instead of pushing duplicate entries.
+/// Wider heaps are flatter and compare siblings in adjacent memory
+/// which is faster than a binary heap for decrease-key heavy searches.
+///
+template <size_t arity = 4>
+struct indexed_heap {
+  static_assert(arity >= 2);
+
+  using index_type = uint32;
+  static constexpr index_type npos = -1;
+
+  struct entry {
+    float32 key;
+    index_type index;
+  };
+
+  indexed_heap() = default;
+  explicit indexed_heap(size_t n) : positions(n, npos) {}
+
+  bool empty() const noexcept { return entries.empty(); }
+  auto size() const noexcept { return entries.size(); }
+  bool contains(index_type i) const noexcept { return positions[i] != npos; }
+  auto top() const noexcept -> const entry& { return entries.front(); }
+
+  /// Allow indices in [0, n) and remove all entries.
+  ///
+  void resize(size_t n) {
+    clear();
+    positions.assign(n, npos);
+  }
+
+  /// Remove all entries by only touching the contained indices.
+  ///
+  void clear() noexcept {
+    for (const auto& e : entries) positions[e.index] = npos;
+    entries.clear();
+  }
+
+  /// Insert the index with the given key or lower its key
+  /// if it is already contained with a larger one.
+  ///
+  void push_or_decrease(index_type i, float32 key) {
+    auto p = positions[i];
+    if (p == npos) {
+      p = index_type(entries.size());
+      entries.push_back({key, i});
+    } else if (key < entries[p].key)
+      entries[p].key = key;
+    else
+      return;
+    sift_up(p);
+  }
+
+  /// Remove and return the entry with the smallest key.
+  ///
+  auto pop() noexcept -> entry {
+    assert(!empty());
+    const auto result = entries.front();
+    positions[result.index] = npos;
+    const auto last = entries.back();
+    entries.pop_back();
+    if (!entries.empty()) {
+      entries.front() = last;
+      positions[last.index] = 0;
+      sift_down(0);
+    }
+    return result;
+  }
+
+  vector<entry> entries{};
+  vector<index_type> positions{};
+
+ private:
+  void sift_up(index_type p) noexcept {
+    const auto e = entries[p];
+    while (p > 0) {
+      const auto parent = (p - 1) / arity;
+      if (entries[parent].key <= e.key) break;
+      entries[p] = entries[parent];
+      positions[entries[p].index] = p;
+      p = parent;
+    }
+    entries[p] = e;
+    positions[e.index] = p;
+  }
+
+  void sift_down(index_type p) noexcept {
+    const auto e = entries[p];
+    const auto n = entries.size();
+    while (true) {
+      const auto first = size_t(p) * arity + 1;
+      if (first >= n) break;
+      const auto last = std::min(first + arity, n);
+      auto child = first;
+      for (auto c = first + 1; c < last; ++c)
+        if (entries[c].key < entries[child].key) child = c;
+      if (e.key <= entries[child].key) break;
+      entries[p] = entries[child];
+      positions[entries[p].index] = p;
+      p = index_type(child);
+    }
+    entries[p] = e;
+    positions[e.index] = p;
+  }
+};
+
+}  // namespace nanoreflex
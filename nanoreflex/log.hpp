@@ -0,0 +1,143 @@
+#pragma once
+#include <nanoreflex/utility.hpp>
+
+// The minimal level of messages and trace events that are compiled in.
+// Everything below is removed at compile time.
+// Override it by '-DNANOREFLEX_LOG_LEVEL=<n>' with the values
+// of 'logging::level', for example '6' to turn off all output.
+//
+#ifndef NANOREFLEX_LOG_LEVEL
+#ifdef NDEBUG
+#define NANOREFLEX_LOG_LEVEL 3
+#else
+#define NANOREFLEX_LOG_LEVEL 2
+#endif
+#endif
+
+namespace nanoreflex::logging {
+
+/// Severity of messages. Per-step output of algorithms
+/// uses 'trace' and phase timings are recorded as 'debug'.
+///
+enum class level : uint8 { trace = 1, debug, info, warning, error, off };
+
+constexpr bool enabled(level l) noexcept {
+  return static_cast<int>(l) >= NANOREFLEX_LOG_LEVEL;
+}
+
+constexpr auto name(level l) noexcept -> czstring {
+  switch (l) {
+    case level::trace:
+      return "TRACE";
+    case level::debug:
+      return "DEBUG";
+    case level::info:
+      return "INFO";
+    case level::warning:
+      return "WARNING";
+    case level::error:
+      return "ERROR";
+    default:
+      return "";
+  }
+}
+
+/// Messages are formatted completely before taking the lock
+/// and are written without flushing the stream.
+/// So, concurrent messages do not interleave
+/// and loops that log do not wait for the terminal.
+///
+inline auto stream_mutex() -> mutex& {
+  static mutex m{};
+  return m;
+}
+
+template <level l>
+inline void write(const auto&... args) {
+  if constexpr (enabled(l)) {
+    ostringstream stream{};
+    stream << '[' << name(l) << "] ";
+    (stream << ... << args);
+    stream << '\n';
+    scoped_lock lock{stream_mutex()};
+    clog << stream.view();
+  }
+}
+
+inline void trace(const auto&... args) { write<level::trace>(args...); }
+inline void debug(const auto&... args) { write<level::debug>(args...); }
+inline void info(const auto&... args) { write<level::info>(args...); }
+inline void warning(const auto&... args) { write<level::warning>(args...); }
+inline void error(const auto&... args) { write<level::error>(args...); }
+
+/// Timing of a named phase of some algorithm.
+/// The name has to be a string literal or outlive the event.
+///
+struct event {
+  czstring name{};
+  thread::id thread_id{};
+  clock::time_point start{};
+  float32 duration{};
+};
+
+/// Recorded events are kept until they are taken.
+///
+struct event_buffer {
+  mutex data_mutex{};
+  vector<event> events{};
+};
+
+inline auto events() -> event_buffer& {
+  static event_buffer buffer{};
+  return buffer;
+}
+
+inline void record(const event& e) {
+  auto& buffer = events();
+  scoped_lock lock{buffer.data_mutex};
+  buffer.events.push_back(e);
+}
+
+/// Return all events recorded so far and clear the buffer.
+///
+inline auto take_events() -> vector<event> {
+  auto& buffer = events();
+  scoped_lock lock{buffer.data_mutex};
+  return std::exchange(buffer.events, {});
+}
+
+/// Record the lifetime of a scope as event.
+/// If tracing is disabled, the type is empty
+/// and construction and destruction vanish.
+///
+template <bool active>
+struct basic_scope {
+  explicit constexpr basic_scope(czstring) noexcept {}
+};
+
+template <>
+struct basic_scope<true> {
+  explicit basic_scope(czstring name) noexcept
+      : name{name}, start{clock::now()} {}
+  ~basic_scope() {
+    const auto end = clock::now();
+    record({name, this_thread::get_id(), start,
+            duration<float32>(end - start).count()});
+  }
+  basic_scope(const basic_scope&) = delete;
+  basic_scope& operator=(const basic_scope&) = delete;
+
+  czstring name;
+  clock::time_point start;
+};
+
+using scope = basic_scope<enabled(level::debug)>;
+
+/// Call 'f' and record its run time as event with the given name.
+///
+inline decltype(auto) timed(czstring name, auto&& f) {
+  const scope s{name};
+  return f();
+}
+
+}  // namespace nanoreflex::logging
@@ -0,0 +1,120 @@
+#pragma once
+#include <nanoreflex/utility.hpp>
+
+namespace nanoreflex {
+
+/// Number of worker threads requested by the user.
+/// Zero means the concurrency reported by the hardware.
+///
+inline auto requested_thread_count() noexcept -> atomic<size_t>& {
+  static atomic<size_t> count{0};
+  return count;
+}
+
+/// Set the number of worker threads used by the parallel algorithms,
+/// for example to measure their scaling.
+/// Zero restores the concurrency reported by the hardware.
+///
+inline void set_thread_count(size_t count) noexcept {
+  requested_thread_count().store(count, memory_order_relaxed);
+}
+
+/// Number of worker threads used by the parallel algorithms.
+/// The hardware may not report its concurrency.
+/// In this case, everything will run on the calling thread.
+///
+inline auto thread_count() noexcept -> size_t {
+  const auto count = requested_thread_count().load(memory_order_relaxed);
+  if (count > 0) return count;
+  return std::max(thread::hardware_concurrency(), 1u);
+}
+
+/// Call 'f(first, last)' for disjoint chunks of at most 'grain' indices
+/// that cover the index range [first, last).
+/// Chunks are dynamically handed out to all available threads
+/// which keeps the load balanced for unevenly expensive chunks.
+/// Exceptions thrown by 'f' are rethrown on the calling thread.
+///
+inline void parallel_for_chunks(size_t first,
+                                size_t last,
+                                auto&& f,
+                                size_t grain = 1024) {
+  if (first >= last) return;
+  grain = std::max(grain, size_t(1));
+  const auto chunks = (last - first + grain - 1) / grain;
+  const auto workers = std::min(thread_count(), chunks);
+
+  // Small ranges are not worth the thread creation.
+  //
+  if (workers <= 1) {
+    f(first, last);
+    return;
+  }
+
+  atomic<size_t> next{first};
+  const auto work = [&] {
+    for (auto i = next.fetch_add(grain); i < last; i = next.fetch_add(grain))
+      f(i, std::min(i + grain, last));
+  };
+
+  vector<future<void>> tasks{};
+  tasks.reserve(workers - 1);
+  for (size_t i = 1; i < workers; ++i)
+    tasks.push_back(async(launch::async, work));
+  work();
+  for (auto& task : tasks) task.get();
+}
+
+/// Call 'f(i)' for every index 'i' in [first, last) in parallel.
+///
+inline void parallel_for(size_t first,
+                         size_t last,
+                         auto&& f,
+                         size_t grain = 1024) {
+  parallel_for_chunks(
+      first, last,
+      [&](size_t a, size_t b) {
+        for (auto i = a; i < b; ++i) f(i);
+      },
+      grain);
+}
+
+/// Replace the values by their inclusive prefix sums.
+/// Chunks are scanned in parallel and their totals serially.
+/// Afterwards, every chunk but the first adds the total of its predecessors.
+/// The order of additions differs from a serial scan
+/// and so may floating-point rounding.
+///
+template <typename type>
+inline void parallel_inclusive_scan(span<type> values, size_t grain = 16384) {
+  grain = std::max(grain, size_t(1));
+  const auto n = values.size();
+  const auto chunks = (n + grain - 1) / grain;
+  const auto chunk = [&](size_t c) {
+    return values.subspan(c * grain, std::min(grain, n - c * grain));
+  };
+
+  if ((chunks <= 1) || (thread_count() <= 1)) {
+    inclusive_scan(begin(values), end(values), begin(values));
+    return;
+  }
+
+  vector<type> totals(chunks);
+  parallel_for(
+      0, chunks,
+      [&](size_t c) {
+        const auto x = chunk(c);
+        inclusive_scan(begin(x), end(x), begin(x));
+        totals[c] = x.back();
+      },
+      1);
+  inclusive_scan(begin(totals), end(totals), begin(totals));
+  parallel_for(
+      1, chunks,
+      [&](size_t c) {
+        for (auto& x : chunk(c)) x += totals[c - 1];
+      },
+      1);
+}
+
+}  // namespace nanoreflex
@@ -12,7 +12,25 @@ struct points {
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vec3), nullptr);
   }
 
-  void update() noexcept { device_vertices.allocate_and_initialize(vertices); }
+  void update() noexcept {
+    device_vertices.allocate_and_initialize(vertices);
+    capacity = vertices.size();
+  }
+
+  /// Only upload the vertices from index 'first' on.
+  /// The device buffer grows geometrically
+  /// so that appended vertices mostly do not need a reallocation.
+  ///
+  void update(size_t first) noexcept {
+    if (vertices.size() > capacity) {
+      capacity = std::max(vertices.size(), 2 * capacity);
+      device_vertices.allocate(capacity * sizeof(vec3));
+      first = 0;
+    }
+    if (first >= vertices.size()) return;
+    device_vertices.write(vertices.data() + first, vertices.size() - first,
+                          first * sizeof(vec3));
+  }
 
   void render() const noexcept {
     device_handle.bind();
@@ -22,6 +40,8 @@ struct points {
   vector<vec3> vertices{};
   opengl::vertex_array device_handle{};
   opengl::vertex_buffer device_vertices{};
+  // Number of vertices the device buffer is able to store.
+  size_t capacity = 0;
 };
 
 }  // namespace nanoreflex
@@ -1,4 +1,6 @@
 #include <nanoreflex/polyhedral_surface.hpp>
+#include <nanoreflex/face_search.hpp>
+#include <nanoreflex/parallel.hpp>
 //
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
@@ -67,6 +69,95 @@ void polyhedral_surface::generate_face_adjacencies() {
   }
 }
 
+auto polyhedral_surface::barycenter(face_id fid) const noexcept -> vec3 {
+  const auto& f = faces[fid];
+  return (position(f[0]) + position(f[1]) + position(f[2])) / 3.0f;
+}
+
+void polyhedral_surface::generate_dual_graph() {
+  face_barycenters.resize(faces.size());
+  parallel_for(0, faces.size(),
+               [&](size_t fid) { face_barycenters[fid] = barycenter(fid); });
+
+  face_adjacency_weights.resize(faces.size());
+  parallel_for(0, faces.size(), [&](size_t fid) {
+    for (size_t i = 0; i < 3; ++i) {
+      const auto n = face_adjacencies[fid][i];
+      face_adjacency_weights[fid][i] =
+          (n == invalid) ? infinity
+                         : distance(face_barycenters[fid],
+                                    face_barycenters[n >> 2]);
+    }
+  });
+}
+
+void polyhedral_surface::generate_corner_angles() {
+  corner_angles.resize(faces.size());
+  parallel_for(0, faces.size(), [&](size_t fid) { update_corner_angles(fid); });
+}
+
+void polyhedral_surface::update_corner_angles(face_id fid) {
+  const auto& f = faces[fid];
+  for (size_t i = 0; i < 3; ++i) {
+    const auto p = position(f[i]);
+    const auto u = normalize(position(f[(i + 1) % 3]) - p);
+    const auto v = normalize(position(f[(i + 2) % 3]) - p);
+    corner_angles[fid][i] = acos(clamp(dot(u, v), -1.0f, 1.0f));
+  }
+}
+
+void polyhedral_surface::generate_vertex_curvatures() {
+  const auto n = topological_vertex_count();
+  angle_defects.assign(n, 0);
+  mean_curvature_normals.assign(n, vec3{});
+  if (faces.empty()) return;
+
+  // Group all face corners by their topological vertex.
+  // Then every vertex gathers its values from its corners
+  // and no accumulation needs to be synchronized.
+  //
+  vector<uint32> labels(3 * faces.size());
+  parallel_for(0, faces.size(), [&](size_t fid) {
+    for (size_t i = 0; i < 3; ++i)
+      labels[3 * fid + i] = topological_vertex(faces[fid][i]);
+  });
+  const discrete_quotient_map<uint32, vertex_id> corners{std::move(labels),
+                                                         vertex_id(n)};
+
+  parallel_for(0, n, [&](size_t v) { update_vertex_curvature(v, corners[v]); });
+}
+
+void polyhedral_surface::update_vertex_curvature(vertex_id v,
+                                                 span<const uint32> corners) {
+  float32 angle_sum = 0;
+  float32 area = 0;
+  vec3 laplacian{};
+  bool boundary = false;
+  for (auto c : corners) {
+    const auto fid = c / 3;
+    const auto i = c % 3;
+    const auto& f = faces[fid];
+    angle_sum += corner_angles[fid][i];
+    boundary = boundary || (face_adjacencies[fid][i] == invalid) ||
+               (face_adjacencies[fid][(i + 2) % 3] == invalid);
+
+    // Every edge gets the cotangent of the opposite corner
+    // from both of its faces.
+    //
+    const auto p = position(f[i]);
+    const auto q = position(f[(i + 1) % 3]);
+    const auto r = position(f[(i + 2) % 3]);
+    const auto area2 = length(cross(q - p, r - p));
+    area += area2 / 6;
+    if (area2 == 0) continue;
+    laplacian += dot(p - r, q - r) / area2 * (p - q) +
+                 dot(p - q, r - q) / area2 * (p - r);
+  }
+  angle_defects[v] = (boundary ? pi : 2 * pi) - angle_sum;
+  mean_curvature_normals[v] =
+      (!boundary && (area > 0)) ? laplacian / (2 * area) : vec3{};
+}
+
 void polyhedral_surface::generate_face_component_map() {
   vector<component_id> face_component(faces.size(), invalid);
 
@@ -117,68 +208,27 @@ bool polyhedral_surface::consistent() const noexcept {
 
 auto polyhedral_surface::shortest_face_path(uint32 src, uint32 dst) const
     -> vector<uint32> {
-  const auto barycenter = [&](uint32 fid) {
-    const auto& f = faces[fid];
-    return (vertices[f[0]].position + vertices[f[1]].position +
-            vertices[f[2]].position) /
-           3.0f;
-  };
-  const auto face_distance = [&](uint32 i, uint32 j) {
-    return glm::distance(barycenter(i), barycenter(j));
-  };
-
-  vector<bool> visited(faces.size(), false);
-
-  vector<float> distances(faces.size(), INFINITY);
-  distances[src] = 0;
-
-  vector<uint32> previous(faces.size());
-  previous[src] = src;
-
-  vector<uint32> queue{src};
-  const auto order = [&](uint32 i, uint32 j) {
-    return distances[i] > distances[j];
-  };
-
-  do {
-    ranges::make_heap(queue, order);
-    ranges::pop_heap(queue, order);
-    const auto current = queue.back();
-    queue.pop_back();
-
-    // cout << "current = " << current << endl;
-
-    visited[current] = true;
-
-    const auto neighbor_faces = face_adjacencies[current];
-    for (int i = 0; i < 3; ++i) {
-      const auto n = neighbor_faces[i];
-      if (n == invalid) continue;
-      const auto neighbor = (n >> 2);
-      if (visited[neighbor]) continue;
-
-      const auto d = face_distance(current, neighbor) + distances[current];
-      if (d >= distances[neighbor]) continue;
-
-      distances[neighbor] = d;
-      previous[neighbor] = (current << 2) | uint32(i);
-      queue.push_back(neighbor);
-    }
-  } while (!queue.empty() && !visited[dst]);
+  face_search search{};
+  return shortest_face_path(src, dst, search);
+}
 
-  if (queue.empty()) return {};
+auto polyhedral_surface::shortest_face_path(uint32 src,
+                                            uint32 dst,
+                                            face_search& search) const
+    -> vector<uint32> {
+  search.run(*this, src, dst);
+  if (!search.reached(dst)) return {};
+  const auto previous = [&](uint32 fid) { return search.predecessor(fid); };
 
   // Compute count and path.
   uint32 count = 0;
-  for (auto i = dst; i != src; i = (previous[i] >> 2)) ++count;
+  for (auto i = dst; i != src; i = (previous(i) >> 2)) ++count;
   vector<uint32> path(count);
-  // for (auto i = dst; i != src; i = (previous[i] >> 2))
-  //   path[--count] = uint32(i << 2) | uint32(previous[i] & 0b11);
   uint32 l = 0;
   for (auto i = dst; i != src;) {
     path[--count] = (i << 2) | l;
-    l = previous[i] & 0b11;
-    i = previous[i] >> 2;
+    l = previous(i) & 0b11;
+    i = previous(i) >> 2;
   }
   return path;
 }
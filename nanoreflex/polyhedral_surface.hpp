@@ -1,12 +1,15 @@
 #pragma once
 #include <nanoreflex/aabb.hpp>
 #include <nanoreflex/discrete_quotient_map.hpp>
+#include <nanoreflex/log.hpp>
 #include <nanoreflex/opengl/opengl.hpp>
 #include <nanoreflex/stl_surface.hpp>
 #include <nanoreflex/utility.hpp>
 
 namespace nanoreflex {
 
+struct face_search;
+
 struct polyhedral_surface {
   using size_type = uint32;
 
@@ -65,6 +68,11 @@ struct polyhedral_surface {
   auto position(face_id fid, real u, real v) const noexcept -> vec3;
 
   auto shortest_face_path(uint32 src, uint32 dst) const -> vector<uint32>;
+  /// Reuse the given search workspace
+  /// to only touch the faces explored by the query.
+  ///
+  auto shortest_face_path(uint32 src, uint32 dst, face_search& search) const
+      -> vector<uint32>;
   auto common_edge(uint32 fid1, uint32 fid2) const -> edge;
   auto location(uint32 fid1, uint32 fid2) const -> uint32;
 
@@ -76,6 +84,37 @@ struct polyhedral_surface {
     return pair{f >> 2, f & 0b11};
   }
 
+  /// Edge of a face at the given location.
+  /// For an encoded face adjacency 'fid << 2 | loc',
+  /// it is the edge shared with the adjacent face
+  /// in the orientation of the adjacent face.
+  /// No adjacencies have to be searched for.
+  ///
+  auto face_edge(face_id fid, uint32 loc) const noexcept -> edge {
+    const auto& f = faces[fid];
+    return {f[loc], f[(loc + 1) % 3]};
+  }
+  auto face_edge(uint32 f) const noexcept -> edge {
+    return face_edge(f >> 2, f & 0b11);
+  }
+
+  // Dual graph of the surface with faces as nodes and face adjacencies
+  // as edges weighted by the distance of the adjacent barycenters.
+  // The weights share the layout of 'face_adjacencies'
+  // and are infinite for boundary edges.
+  // So, graph searches neither gather vertices nor compute roots.
+  face_map<vec3> face_barycenters{};
+  face_map<array<float32, 3>> face_adjacency_weights{};
+  void generate_dual_graph();
+  auto barycenter(face_id fid) const noexcept -> vec3;
+
+  // Interior angles of all faces at their corners.
+  // The angle at 'faces[fid][i]' is stored in 'corner_angles[fid][i]'.
+  // Angle sums over vertex fans then need no roots or inverse cosines.
+  face_map<array<float32, 3>> corner_angles{};
+  void generate_corner_angles();
+  void update_corner_angles(face_id fid);
+
   discrete_quotient_map<vertex_id, vertex_id> topological_vertex_map{};
   void generate_topological_vertex_map();
 
@@ -93,8 +132,25 @@ struct polyhedral_surface {
            views::transform([&](auto vid) { return vertices[vid]; });
   }
 
+  // Discrete curvature of all topological vertices.
+  // The angle defect is the Gaussian curvature integrated over the vertex
+  // and is taken against 'pi' instead of '2 pi' for boundary vertices.
+  // So, the sum of all defects is '2 pi' times the Euler characteristic.
+  // Mean curvature normals are the cotangent Laplacian of the positions
+  // divided by the barycentric vertex area.
+  // Their length is twice the mean curvature and they vanish on boundaries.
+  vertex_map<float32> angle_defects{};
+  vertex_map<vec3> mean_curvature_normals{};
+  void generate_vertex_curvatures();
+  /// Compute the curvature of a topological vertex
+  /// from all face corners '3 * fid + i' around it.
+  ///
+  void update_vertex_curvature(vertex_id v, span<const uint32> corners);
+
   using component_id = face_id;
-  discrete_quotient_map<face_id, component_id> face_component_map{};
+  // Components change locally when the surface is cut.
+  // So, their faces are not stored in one contiguous array.
+  dynamic_quotient_map<face_id, component_id> face_component_map{};
 
   void generate_face_component_map();
   auto component_count() const noexcept {
@@ -110,18 +166,25 @@ struct polyhedral_surface {
   }
 
   void generate_topological_structure() {
-    generate_topological_vertex_map();
-    cout << "topological vertex map generated" << endl;
-    generate_edges();
-    cout << "edges generated" << endl;
-    generate_face_adjacencies();
-    cout << "face adjacencies generated" << endl;
-    generate_face_component_map();
-    cout << "face component map generated" << endl;
+    const logging::scope total{"topological structure"};
+    logging::timed("topological vertex map",
+                   [&] { generate_topological_vertex_map(); });
+    logging::timed("edges", [&] { generate_edges(); });
+    logging::timed("face adjacencies", [&] { generate_face_adjacencies(); });
+    logging::timed("dual graph", [&] { generate_dual_graph(); });
+    logging::timed("corner angles", [&] { generate_corner_angles(); });
+    logging::timed("vertex curvatures",
+                   [&] { generate_vertex_curvatures(); });
+    logging::timed("face component map",
+                   [&] { generate_face_component_map(); });
   }
 
   struct surface_mesh_curve {
     constexpr auto size() const noexcept { return edge_weights.size(); }
+    constexpr bool closed() const noexcept {
+      return (face_strip.size() > 2) &&
+             ((face_strip.front() >> 2) == (face_strip.back() >> 2));
+    }
     constexpr void clear() {
       face_strip.clear();
       edge_weights.clear();
@@ -131,9 +194,118 @@ struct polyhedral_surface {
   };
   bool valid(const surface_mesh_curve& curve) const noexcept;
   auto points_from(const surface_mesh_curve& curve) const -> vector<vec3>;
+  /// Only recompute the points of all edges from index 'first' on
+  /// and resize the points to the curve.
+  ///
+  void update_points(const surface_mesh_curve& curve,
+                     size_t first,
+                     vector<vec3>& points) const;
+
+  /// Point inside a face given by the barycentric coordinates
+  /// of its second and third vertex.
+  ///
+  struct face_point {
+    face_id face;
+    real u;
+    real v;
+  };
+  auto position(const face_point& x) const noexcept -> vec3 {
+    return position(x.face, x.u, x.v);
+  }
+
+  /// Cumulative arc length of the polygon through the points of the curve.
+  /// The first value is zero and the last one is the length of the curve.
+  ///
+  auto arc_lengths(const surface_mesh_curve& curve) const -> vector<float32>;
+  /// Sample the polygon of the curve at 'count' points
+  /// with equal arc length in between, including both end points.
+  /// Independent of the mesh resolution, the sample count stays bounded.
+  ///
+  auto resample(const surface_mesh_curve& curve, size_t count) const
+      -> vector<face_point>;
+  /// Sample the polygon of the curve at all multiples of the given spacing.
+  /// The end point is added if the length is no multiple of it.
+  ///
+  auto resample_with_spacing(const surface_mesh_curve& curve,
+                             float32 spacing) const -> vector<face_point>;
+
+  /// Crossing of two segments of surface mesh curves.
+  /// Segment 'k' of a curve connects the points of its edges 'k' and 'k + 1'
+  /// inside the face 'face_strip[k + 1]'.
+  /// Closed curves get another segment from their last to their first point.
+  ///
+  struct curve_crossing {
+    array<uint32, 2> curves;
+    array<uint32, 2> segments;
+    face_point point;
+  };
+  /// Find all crossings of the given curves with each other and themselves.
+  /// Every segment lies inside a single face.
+  /// So, segments are bucketed by faces and only tested inside a bucket
+  /// in barycentric coordinates of the face.
+  /// Crossings at mesh edges may be reported for both adjacent faces.
+  ///
+  auto crossings(span<const surface_mesh_curve> curves) const
+      -> vector<curve_crossing>;
+  auto self_intersections(const surface_mesh_curve& curve) const
+      -> vector<curve_crossing>;
+  bool simple(const surface_mesh_curve& curve) const;
+
+  /// Mark all faces on the left or right side of a closed curve.
+  /// Faces of the strip are cut by the curve into a left and right piece.
+  /// Other faces only reach a strip face through its edge not crossed
+  /// and pieces of the same side are connected along the strip.
+  /// A parallel breadth-first search from the first piece of the given side
+  /// then fills the region without ever crossing the curve.
+  /// So, the side is given with respect to the orientation
+  /// of the first face of the strip.
+  /// Strip faces belong to the side of their edge that is not crossed.
+  /// Non-separating curves, like meridians of a torus, select everything.
+  /// Every face is assumed to be split once.
+  /// So, curves visiting a face more than once are rejected.
+  ///
+  auto region_from(const surface_mesh_curve& curve, bool left) const
+      -> vector<bool>;
+
+  /// Cut the surface along the curve.
+  /// Every point of the curve becomes two new vertices on its edge,
+  /// one for each side, and the faces of the strip are split into triangles.
+  /// The end points of open curves are not duplicated and so open slits.
+  /// Edge weights are kept away from the vertices of their edge
+  /// by a small relative distance to not create degenerate faces.
+  /// Edges, adjacencies, dual graph, corner angles, curvatures,
+  /// and components are only updated around the strip.
+  /// A closed curve that separates its component moves the smaller side
+  /// to a new component which is found by searching both sides alternately.
+  /// For non-separating curves, this search may visit the whole component.
+  /// New vertices are their own topological vertices.
+  /// So, regenerating the topological structure would glue the cut again.
+  /// Curves visiting a face more than once are rejected.
+  ///
+  void cut(const surface_mesh_curve& curve);
+
+  /// Replace the edge weights of the curve by the shortest path
+  /// inside its face strip between the barycenters of its end faces.
+  /// The strip is unfolded into the plane
+  /// and the funnel algorithm computes the path in linear time.
+  /// So, no iterated smoothing is needed.
+  ///
+  void straighten(surface_mesh_curve& curve) const;
   auto shortest_surface_mesh_curve(face_id src, face_id dst) const
       -> surface_mesh_curve;
-  void add_face(surface_mesh_curve& curve, face_id fid) const;
+  auto shortest_surface_mesh_curve(face_id src,
+                                   face_id dst,
+                                   face_search& search) const
+      -> surface_mesh_curve;
+  /// Extend the curve by the shortest face path to the given face.
+  /// Return the index of the first strip entry that has changed.
+  /// All strip entries and edge weights before it are kept.
+  /// If the curve has not changed, the size of its strip is returned.
+  ///
+  auto add_face(surface_mesh_curve& curve, face_id fid) const -> size_t;
+  auto add_face(surface_mesh_curve& curve,
+                face_id fid,
+                face_search& search) const -> size_t;
 
   auto critical_points_from(const surface_mesh_curve& curve) const
       -> vector<vec3>;
@@ -169,6 +341,38 @@ struct scene : polyhedral_surface {
   void update() noexcept {
     device_vertices.allocate_and_initialize(vertices);
     device_faces.allocate_and_initialize(faces);
+    vertex_capacity = vertices.size();
+    face_capacity = faces.size();
+  }
+
+  /// Only upload the vertices and faces appended after the given counts
+  /// and the given faces that have been changed in place.
+  /// The device buffers grow geometrically
+  /// and are only uploaded completely when they have to be reallocated.
+  ///
+  void update(size_t vertex_count,
+              size_t face_count,
+              span<const face_id> changed) noexcept {
+    if (vertices.size() > vertex_capacity) {
+      vertex_capacity = std::max(vertices.size(), 2 * vertex_capacity);
+      device_vertices.allocate(vertex_capacity * sizeof(vertex));
+      vertex_count = 0;
+    }
+    if (vertex_count < vertices.size())
+      device_vertices.write(vertices.data() + vertex_count,
+                            vertices.size() - vertex_count,
+                            vertex_count * sizeof(vertex));
+    if (faces.size() > face_capacity) {
+      face_capacity = std::max(faces.size(), 2 * face_capacity);
+      device_faces.allocate(face_capacity * sizeof(face));
+      face_count = 0;
+    }
+    if (face_count < faces.size())
+      device_faces.write(faces.data() + face_count, faces.size() - face_count,
+                         face_count * sizeof(face));
+    for (auto fid : changed)
+      if (fid < face_count)
+        device_faces.write(&faces[fid], 1, fid * sizeof(face));
   }
 
   void render() const noexcept {
@@ -180,6 +384,9 @@ struct scene : polyhedral_surface {
   opengl::vertex_array device_handle{};
   opengl::vertex_buffer device_vertices{};
   opengl::element_buffer device_faces{};
+  // Number of vertices and faces the device buffers are able to store.
+  size_t vertex_capacity = 0;
+  size_t face_capacity = 0;
 };
 
 }  // namespace nanoreflex
@@ -2,15 +2,200 @@
 
 namespace nanoreflex {
 
+namespace {
+
+// Front-to-back traversal of a BVH along a ray.
+// 'tmax' references the distance of the current closest hit
+// and is used to prune all nodes that lie behind it.
+// The leaf function is responsible for updating 'tmax'.
+//
+void traverse(const ray& r,
+              const vec3& inverse_direction,
+              const bvh& tree,
+              const float& tmax,
+              auto&& process) noexcept {
+  if (tree.empty()) return;
+  if (!intersection(r, inverse_direction, tree.box(), tmax)) return;
+
+  struct entry {
+    bvh::index_type node;
+    float t;
+  };
+  entry stack[64];
+  size_t top = 0;
+  stack[top++] = {0, 0.0f};
+
+  while (top > 0) {
+    const auto [n, t] = stack[--top];
+    if (t >= tmax) continue;
+    const auto& node = tree.nodes[n];
+    if (node.leaf()) {
+      process(tree.leaf_primitives(node));
+      continue;
+    }
+    const auto left = node.offset;
+    const auto right = node.offset + 1;
+    const auto l =
+        intersection(r, inverse_direction, tree.nodes[left].box, tmax);
+    const auto h =
+        intersection(r, inverse_direction, tree.nodes[right].box, tmax);
+    // Push the farther child first to process the nearer one first.
+    if (l && h) {
+      if (l.tmin <= h.tmin) {
+        stack[top++] = {right, h.tmin};
+        stack[top++] = {left, l.tmin};
+      } else {
+        stack[top++] = {left, l.tmin};
+        stack[top++] = {right, h.tmin};
+      }
+    } else if (l)
+      stack[top++] = {left, l.tmin};
+    else if (h)
+      stack[top++] = {right, h.tmin};
+  }
+}
+
+// Front-to-back traversal of a compressed four-wide BVH along a ray.
+// All four child boxes of a node are tested at once.
+// Leaves are pushed onto the stack like nodes
+// to also process them in front-to-back order.
+//
+void traverse(const ray& r,
+              const vec3& inverse_direction,
+              const wide_bvh& tree,
+              const float& tmax,
+              auto&& process) noexcept {
+  constexpr auto width = wide_bvh::width;
+  if (tree.empty()) return;
+  if (!intersection(r, inverse_direction, tree.box(), tmax)) return;
+
+  struct entry {
+    wide_bvh::index_type index;
+    uint32 count;
+    float t;
+  };
+  entry stack[3 * 64 + width];
+  size_t top = 0;
+  stack[top++] = {0, 0, 0.0f};
+
+  while (top > 0) {
+    const auto [index, count, t] = stack[--top];
+    if (t >= tmax) continue;
+    if (count != 0) {
+      process(index, count);
+      continue;
+    }
+
+    const auto& node = tree.nodes[index];
+    const auto s = node.scale();
+    const auto slab = [&](int k, uint8 q) {
+      return (node.origin[k] + s[k] * q - r.origin[k]) * inverse_direction[k];
+    };
+
+    // Slab tests for all children in a structure-of-arrays layout.
+    //
+    float enter[width];
+    float leave[width];
+    for (size_t i = 0; i < width; ++i) {
+      const auto x1 = slab(0, node.lo[0][i]);
+      const auto x2 = slab(0, node.hi[0][i]);
+      const auto y1 = slab(1, node.lo[1][i]);
+      const auto y2 = slab(1, node.hi[1][i]);
+      const auto z1 = slab(2, node.lo[2][i]);
+      const auto z2 = slab(2, node.hi[2][i]);
+      enter[i] = std::max(std::max(std::min(x1, x2), std::min(y1, y2)),
+                          std::max(std::min(z1, z2), 0.0f));
+      leave[i] = std::min(std::min(std::max(x1, x2), std::max(y1, y2)),
+                          std::min(std::max(z1, z2), tmax));
+    }
+
+    // Sort the hit children by their distance
+    // and push the farthest one first.
+    //
+    size_t hits[width];
+    size_t n = 0;
+    for (size_t i = 0; i < width; ++i) {
+      if (node.empty(i) || enter[i] > leave[i]) continue;
+      auto j = n++;
+      for (; j > 0 && enter[hits[j - 1]] < enter[i]; --j) hits[j] = hits[j - 1];
+      hits[j] = i;
+    }
+    for (size_t j = 0; j < n; ++j) {
+      const auto i = hits[j];
+      stack[top++] = {node.child[i], node.count[i], enter[i]};
+    }
+  }
+}
+
+void intersect(const ray& r,
+               const vec3& inverse_direction,
+               const polyhedral_surface& surface,
+               const wide_bvh& tree,
+               ray_polyhedral_surface_intersection& result) noexcept {
+  traverse(r, inverse_direction, tree, result.t, [&](auto index, auto count) {
+    const auto& v = surface.vertices;
+    for (auto i = index; i < index + count; ++i) {
+      const auto fid = tree.primitives[i];
+      const auto& f = surface.faces[fid];
+      const triangle t{v[f[0]].position, v[f[1]].position, v[f[2]].position};
+      if (const auto p = intersection(r, t)) {
+        if (p.t >= result.t) continue;
+        static_cast<ray_triangle_intersection&>(result) = p;
+        result.f = fid;
+      }
+    }
+  });
+}
+
+// With the triangle cache, leaves read their triangles contiguously.
+// The face ID only needs to be loaded for actual hits.
+//
+void intersect(const ray& r,
+               const vec3& inverse_direction,
+               const wide_bvh& tree,
+               const vector<surface_bvh::cached_triangle>& triangles,
+               ray_polyhedral_surface_intersection& result) noexcept {
+  traverse(r, inverse_direction, tree, result.t, [&](auto index, auto count) {
+    for (auto i = index; i < index + count; ++i) {
+      if (const auto p = intersection(r, triangles[i])) {
+        if (p.t >= result.t) continue;
+        static_cast<ray_triangle_intersection&>(result) = p;
+        result.f = tree.primitives[i];
+      }
+    }
+  });
+}
+
+void intersect(const ray& r,
+               const vec3& inverse_direction,
+               const polyhedral_surface& surface,
+               const surface_bvh& tree,
+               surface_bvh::component_id cid,
+               ray_polyhedral_surface_intersection& result) noexcept {
+  if (tree.cached())
+    intersect(r, inverse_direction, tree.components[cid], tree.triangles[cid],
+              result);
+  else
+    intersect(r, inverse_direction, surface, tree.components[cid], result);
+}
+
+}  // namespace
+
 auto intersection(const ray& r, const triangle& f) noexcept
     -> ray_triangle_intersection {
-  const auto edge1 = f[1] - f[0];
-  const auto edge2 = f[2] - f[0];
+  return intersection(r, surface_bvh::cached_triangle{f[0], f[1] - f[0],
+                                                      f[2] - f[0]});
+}
+
+auto intersection(const ray& r, const surface_bvh::cached_triangle& f) noexcept
+    -> ray_triangle_intersection {
+  const auto& edge1 = f.edge1;
+  const auto& edge2 = f.edge2;
   const auto p = cross(r.direction, edge2);
   const auto determinant = dot(edge1, p);
   if (0.0f == determinant) return {};
   const auto inverse_determinant = 1.0f / determinant;
-  const auto s = r.origin - f[0];
+  const auto s = r.origin - f.origin;
   float u = dot(s, p) * inverse_determinant;
   const auto q = cross(s, edge1);
   float v = dot(r.direction, q) * inverse_determinant;
@@ -25,8 +210,8 @@ auto intersection(const ray& r, const polyhedral_surface& surface) noexcept
   for (size_t i = 0; i < surface.faces.size(); ++i) {
     const auto& v = surface.vertices;
     const auto& f = surface.faces[i];
-    if (const auto p = intersection(
-            r, {v[f[0]].position, v[f[1]].position, v[f[2]].position})) {
+    const triangle t{v[f[0]].position, v[f[1]].position, v[f[2]].position};
+    if (const auto p = intersection(r, t)) {
       if (p.t >= result.t) continue;
       static_cast<ray_triangle_intersection&>(result) = p;
       result.f = i;
@@ -35,4 +220,31 @@ auto intersection(const ray& r, const polyhedral_surface& surface) noexcept
   return result;
 }
 
+auto intersection(const ray& r,
+                  const polyhedral_surface& surface,
+                  const surface_bvh& tree) noexcept
+    -> ray_polyhedral_surface_intersection {
+  ray_polyhedral_surface_intersection result{};
+  result.t = infinity;
+  const auto inverse_direction = 1.0f / r.direction;
+  traverse(r, inverse_direction, tree.top, result.t, [&](auto cids) {
+    for (auto cid : cids) {
+      if (!tree.visible(cid)) continue;
+      intersect(r, inverse_direction, surface, tree, cid, result);
+    }
+  });
+  return result;
+}
+
+auto intersection(const ray& r,
+                  const polyhedral_surface& surface,
+                  const surface_bvh& tree,
+                  polyhedral_surface::component_id cid) noexcept
+    -> ray_polyhedral_surface_intersection {
+  ray_polyhedral_surface_intersection result{};
+  result.t = infinity;
+  intersect(r, 1.0f / r.direction, surface, tree, cid, result);
+  return result;
+}
+
 }  // namespace nanoreflex
@@ -1,5 +1,6 @@
 #pragma once
 #include <nanoreflex/polyhedral_surface.hpp>
+#include <nanoreflex/surface_bvh.hpp>
 
 namespace nanoreflex {
 
@@ -10,6 +11,29 @@ struct ray {
   vec3 direction;
 };
 
+struct ray_aabb_intersection {
+  operator bool() const noexcept { return tmin <= tmax; }
+  float tmin{};
+  float tmax{};
+};
+
+/// Slab test of a ray against a box in the interval [0, tmax].
+/// The component-wise inverse of the ray direction
+/// is only computed once for a whole traversal and therefore provided.
+///
+inline auto intersection(const ray& r,
+                         const vec3& inverse_direction,
+                         const aabb3& box,
+                         float tmax = infinity) noexcept
+    -> ray_aabb_intersection {
+  const auto t1 = (box._min - r.origin) * inverse_direction;
+  const auto t2 = (box._max - r.origin) * inverse_direction;
+  const auto enter = max(min(t1, t2), vec3{0.0f});
+  const auto leave = min(max(t1, t2), vec3{tmax});
+  return {std::max(std::max(enter.x, enter.y), enter.z),
+          std::min(std::min(leave.x, leave.y), leave.z)};
+}
+
 struct triangle : array<vec3, 3> {};
 
 struct ray_triangle_intersection {
@@ -25,6 +49,9 @@ struct ray_triangle_intersection {
 auto intersection(const ray& r, const triangle& f) noexcept
     -> ray_triangle_intersection;
 
+auto intersection(const ray& r, const surface_bvh::cached_triangle& f) noexcept
+    -> ray_triangle_intersection;
+
 struct ray_polyhedral_surface_intersection : ray_triangle_intersection {
   // We overwrite the check,
   // because it the triangle will already have been checked.
@@ -35,4 +62,20 @@ struct ray_polyhedral_surface_intersection : ray_triangle_intersection {
 auto intersection(const ray& r, const polyhedral_surface& scene) noexcept
     -> ray_polyhedral_surface_intersection;
 
+/// Accelerated intersection with all visible components of the surface.
+///
+auto intersection(const ray& r,
+                  const polyhedral_surface& surface,
+                  const surface_bvh& tree) noexcept
+    -> ray_polyhedral_surface_intersection;
+
+/// Accelerated intersection that is restricted to a single component.
+/// The visibility of the component is ignored.
+///
+auto intersection(const ray& r,
+                  const polyhedral_surface& surface,
+                  const surface_bvh& tree,
+                  polyhedral_surface::component_id cid) noexcept
+    -> ray_polyhedral_surface_intersection;
+
 }  // namespace nanoreflex
@@ -0,0 +1,140 @@
+#include <nanoreflex/sparse_ldlt.hpp>
+
+namespace nanoreflex {
+
+auto sparse_matrix_from(size_t n, vector<sparse_matrix::triplet> triplets)
+    -> sparse_matrix {
+  ranges::sort(triplets, [](const auto& x, const auto& y) {
+    return (x.column < y.column) || ((x.column == y.column) && (x.row < y.row));
+  });
+
+  sparse_matrix result{};
+  result.column_offsets.assign(n + 1, 0);
+  for (size_t i = 0; i < triplets.size();) {
+    const auto [row, column, _] = triplets[i];
+    float64 value = 0;
+    for (; (i < triplets.size()) && (triplets[i].row == row) &&
+           (triplets[i].column == column);
+         ++i)
+      value += triplets[i].value;
+    result.rows.push_back(row);
+    result.values.push_back(value);
+    ++result.column_offsets[column + 1];
+  }
+  for (size_t j = 0; j < n; ++j)
+    result.column_offsets[j + 1] += result.column_offsets[j];
+  return result;
+}
+
+// The symbolic and numeric phases follow the up-looking algorithm
+// of Timothy A. Davis used in his LDL package.
+// Row k of L is given by the reach of the nonzero pattern
+// of column k of the permuted matrix in the elimination tree.
+
+void sparse_ldlt::analyze(const sparse_matrix& a,
+                          vector<index_type> permutation) {
+  constexpr auto none = index_type(-1);
+  const auto n = a.size();
+  assert(permutation.size() == n);
+  this->permutation = std::move(permutation);
+  inverse_permutation.resize(n);
+  for (size_t k = 0; k < n; ++k)
+    inverse_permutation[this->permutation[k]] = k;
+
+  parent.assign(n, none);
+  vector<index_type> flags(n);
+  vector<index_type> counts(n, 0);
+  for (index_type k = 0; k < n; ++k) {
+    flags[k] = k;
+    const auto column = this->permutation[k];
+    for (auto p = a.column_offsets[column]; p < a.column_offsets[column + 1];
+         ++p) {
+      // Walk up the elimination tree until a visited column is found.
+      for (auto i = inverse_permutation[a.rows[p]]; (i < k) && (flags[i] != k);
+           i = parent[i]) {
+        if (parent[i] == none) parent[i] = k;
+        ++counts[i];
+        flags[i] = k;
+      }
+    }
+  }
+
+  column_offsets.assign(n + 1, 0);
+  for (size_t k = 0; k < n; ++k)
+    column_offsets[k + 1] = column_offsets[k] + counts[k];
+  rows.resize(column_offsets[n]);
+  values.resize(column_offsets[n]);
+  diagonal.resize(n);
+}
+
+bool sparse_ldlt::factorize(const sparse_matrix& a) {
+  const auto n = size();
+  assert(a.size() == n);
+
+  vector<float64> y(n, 0);
+  vector<index_type> pattern(n);
+  vector<index_type> flags(n);
+  vector<index_type> counts(n, 0);
+
+  for (index_type k = 0; k < n; ++k) {
+    // Scatter column k of the permuted matrix into 'y'
+    // and compute the nonzero pattern of row k of L
+    // in topological order of the elimination tree.
+    //
+    auto top = n;
+    flags[k] = k;
+    const auto column = permutation[k];
+    for (auto p = a.column_offsets[column]; p < a.column_offsets[column + 1];
+         ++p) {
+      auto i = inverse_permutation[a.rows[p]];
+      if (i > k) continue;
+      y[i] += a.values[p];
+      size_t length = 0;
+      for (; flags[i] != k; i = parent[i]) {
+        pattern[length++] = i;
+        flags[i] = k;
+      }
+      while (length > 0) pattern[--top] = pattern[--length];
+    }
+
+    // Sparse triangular solve for row k of L.
+    //
+    diagonal[k] = y[k];
+    y[k] = 0;
+    for (; top < n; ++top) {
+      const auto i = pattern[top];
+      const auto yi = y[i];
+      y[i] = 0;
+      const auto last = column_offsets[i] + counts[i];
+      for (auto p = column_offsets[i]; p < last; ++p)
+        y[rows[p]] -= values[p] * yi;
+      const auto l = yi / diagonal[i];
+      diagonal[k] -= l * yi;
+      rows[last] = k;
+      values[last] = l;
+      ++counts[i];
+    }
+    if (diagonal[k] == 0) return false;
+  }
+  return true;
+}
+
+void sparse_ldlt::solve(span<float64> x) const {
+  const auto n = size();
+  assert(x.size() == n);
+
+  vector<float64> y(n);
+  for (size_t k = 0; k < n; ++k) y[k] = x[permutation[k]];
+
+  for (size_t j = 0; j < n; ++j)
+    for (auto p = column_offsets[j]; p < column_offsets[j + 1]; ++p)
+      y[rows[p]] -= values[p] * y[j];
+  for (size_t j = 0; j < n; ++j) y[j] /= diagonal[j];
+  for (auto j = n; j-- > 0;)
+    for (auto p = column_offsets[j]; p < column_offsets[j + 1]; ++p)
+      y[j] -= values[p] * y[rows[p]];
+
+  for (size_t k = 0; k < n; ++k) x[permutation[k]] = y[k];
+}
+
+}  // namespace nanoreflex
@@ -0,0 +1,77 @@
+#pragma once
+#include <nanoreflex/utility.hpp>
+
+namespace nanoreflex {
+
+/// Square sparse matrix in compressed sparse column format.
+/// Symmetric matrices have to store both of their triangles.
+///
+struct sparse_matrix {
+  using index_type = uint32;
+
+  struct triplet {
+    index_type row;
+    index_type column;
+    float64 value;
+  };
+
+  auto size() const noexcept -> size_t {
+    return column_offsets.empty() ? 0 : column_offsets.size() - 1;
+  }
+  auto nonzeros() const noexcept { return rows.size(); }
+
+  vector<index_type> column_offsets{};
+  vector<index_type> rows{};
+  vector<float64> values{};
+};
+
+/// Assemble an n x n sparse matrix from unordered triplets.
+/// Values of duplicated entries are summed up.
+///
+auto sparse_matrix_from(size_t n, vector<sparse_matrix::triplet> triplets)
+    -> sparse_matrix;
+
+/// Sparse LDLT factorization of a symmetric positive definite matrix
+/// given by a permutation P with P A P^T = L D L^T.
+/// The symbolic analysis only depends on the sparsity pattern.
+/// It computes the elimination tree and the column counts of L.
+/// So, matrices with the same pattern can share one analysis
+/// and one factorization serves any number of right-hand sides.
+/// The permutation should reduce the fill-in of L.
+///
+struct sparse_ldlt {
+  using index_type = sparse_matrix::index_type;
+
+  auto size() const noexcept { return diagonal.size(); }
+  auto nonzeros() const noexcept { return rows.size(); }
+  auto memory_usage() const noexcept -> size_t {
+    return rows.size() * (sizeof(index_type) + sizeof(float64)) +
+           size() * (sizeof(float64) + 4 * sizeof(index_type));
+  }
+
+  /// 'permutation[k]' is the row and column of 'a'
+  /// that will be eliminated in the k-th step.
+  ///
+  void analyze(const sparse_matrix& a, vector<index_type> permutation);
+
+  /// Compute the numeric factors for a matrix with the analyzed pattern.
+  /// Returns false if a zero pivot occurs.
+  ///
+  bool factorize(const sparse_matrix& a);
+
+  /// Solve 'A x = b' in place.
+  ///
+  void solve(span<float64> x) const;
+
+  vector<index_type> permutation{};
+  vector<index_type> inverse_permutation{};
+  // Elimination tree given by the parent of every column.
+  vector<index_type> parent{};
+  // Strictly lower triangle of L in compressed sparse column format.
+  vector<index_type> column_offsets{};
+  vector<index_type> rows{};
+  vector<float64> values{};
+  vector<float64> diagonal{};
+};
+
+}  // namespace nanoreflex
@@ -0,0 +1,293 @@
+#include <nanoreflex/parallel.hpp>
+#include <nanoreflex/surface_bvh.hpp>
+
+namespace nanoreflex {
+
+namespace {
+
+auto face_box(const polyhedral_surface& surface,
+              polyhedral_surface::face_id fid) noexcept -> aabb3 {
+  const auto& f = surface.faces[fid];
+  return aabb(aabb(surface.position(f[0]), surface.position(f[1])),
+              surface.position(f[2]));
+}
+
+auto triangle(const polyhedral_surface& surface,
+              polyhedral_surface::face_id fid) noexcept
+    -> surface_bvh::cached_triangle {
+  const auto& f = surface.faces[fid];
+  const auto origin = surface.position(f[0]);
+  return {origin, surface.position(f[1]) - origin,
+          surface.position(f[2]) - origin};
+}
+
+auto component_bvh_from(const polyhedral_surface& surface,
+                        polyhedral_surface::component_id cid) -> wide_bvh {
+  const auto fids = surface.component_face_ids(cid);
+  vector<aabb3> boxes(fids.size());
+  for (size_t i = 0; i < fids.size(); ++i)
+    boxes[i] = face_box(surface, fids[i]);
+  auto tree = bvh_from(boxes);
+  boxes = {};
+  // Let the bottom level directly reference face IDs.
+  for (auto& p : tree.primitives) p = fids[p];
+  return wide_bvh_from(move(tree));
+}
+
+auto triangles_from(const polyhedral_surface& surface, const wide_bvh& tree)
+    -> vector<surface_bvh::cached_triangle> {
+  vector<surface_bvh::cached_triangle> result(tree.primitives.size());
+  for (size_t i = 0; i < result.size(); ++i)
+    result[i] = triangle(surface, tree.primitives[i]);
+  return result;
+}
+
+/// Call 'process(leaf, depth)' for every leaf of the hierarchy
+/// whose boxes along the path to the root all contain the given box.
+/// Leaves are given by '(node << 2) | slot'.
+///
+void for_each_leaf_containing(const wide_bvh& tree,
+                              const aabb3& box,
+                              auto&& process) {
+  const auto contains = [&](const aabb3& b) {
+    for (int k = 0; k < 3; ++k)
+      if ((b._min[k] > box._min[k]) || (box._max[k] > b._max[k]))
+        return false;
+    return true;
+  };
+  if (tree.empty() || !contains(tree.box())) return;
+
+  vector<pair<wide_bvh::index_type, uint32>> stack{{0, 1}};
+  while (!stack.empty()) {
+    const auto [index, depth] = stack.back();
+    stack.pop_back();
+    const auto& node = tree.nodes[index];
+    for (uint32 i = 0; i < wide_bvh::width; ++i) {
+      if (node.empty(i) || !contains(node.box(i))) continue;
+      if (node.leaf(i))
+        process((index << 2) | i, depth);
+      else
+        stack.push_back({node.child[i], depth + 1});
+    }
+  }
+}
+
+/// Take the removed faces out of the leaves of the bottom level
+/// and put the inserted faces into leaves whose boxes contain them.
+/// Only these leaves are replaced by appending their new primitives,
+/// or a small subtree if there are too many, and all other nodes are kept.
+/// Return false and change nothing if this cannot be done locally.
+///
+bool update_leaves(surface_bvh& tree,
+                   const polyhedral_surface& surface,
+                   polyhedral_surface::component_id cid,
+                   span<const polyhedral_surface::face_id> removed,
+                   span<const polyhedral_surface::face_id> inserted) {
+  using face_id = polyhedral_surface::face_id;
+  constexpr auto invalid = polyhedral_surface::invalid;
+  // Larger leaves are split into a subtree.
+  constexpr size_t leaf_capacity = 16;
+  // Grafted subtrees add levels and traversals only provide
+  // a fixed stack size. Deeper leaves are not updated locally.
+  constexpr uint32 max_depth = 48;
+
+  auto& bottom = tree.components[cid];
+  unordered_map<uint32, vector<face_id>> leaves{};
+  const auto open = [&](uint32 leaf) -> vector<face_id>& {
+    const auto [it, created] = leaves.try_emplace(leaf);
+    if (created) {
+      const auto p = bottom.leaf_primitives(bottom.nodes[leaf >> 2], leaf & 3);
+      it->second.assign(begin(p), end(p));
+    }
+    return it->second;
+  };
+
+  for (auto fid : removed) {
+    auto found = invalid;
+    for_each_leaf_containing(
+        bottom, face_box(surface, fid), [&](uint32 leaf, uint32 depth) {
+          if ((found != invalid) || (depth > max_depth)) return;
+          const auto p =
+              bottom.leaf_primitives(bottom.nodes[leaf >> 2], leaf & 3);
+          if (ranges::find(p, fid) != end(p)) found = leaf;
+        });
+    if (found == invalid) return false;
+    auto& primitives = open(found);
+    primitives.erase(ranges::find(primitives, fid));
+  }
+
+  // Pieces lie inside the face they were cut from.
+  // So, leaves that already change are preferred.
+  //
+  for (auto fid : inserted) {
+    auto found = invalid;
+    for_each_leaf_containing(
+        bottom, face_box(surface, fid), [&](uint32 leaf, uint32 depth) {
+          if (depth > max_depth) return;
+          if ((found == invalid) || leaves.contains(leaf)) found = leaf;
+        });
+    if (found == invalid) return false;
+    open(found).push_back(fid);
+  }
+
+  // Unreachable primitives and nodes accumulate with every update.
+  // Once they outweigh the component, it is better rebuilt.
+  //
+  size_t added = 0;
+  for (const auto& [leaf, primitives] : leaves) added += primitives.size();
+  if (bottom.primitives.size() + added >
+      2 * surface.component_face_ids(cid).size() + leaf_capacity)
+    return false;
+
+  const auto first = bottom.primitives.size();
+  for (const auto& [leaf, primitives] : leaves) {
+    const auto index = leaf >> 2;
+    const auto slot = leaf & 3;
+    if (primitives.empty()) {
+      bottom.nodes[index].child[slot] = wide_bvh::invalid;
+      bottom.nodes[index].count[slot] = 0;
+      continue;
+    }
+    if (primitives.size() <= leaf_capacity) {
+      bottom.nodes[index].child[slot] = bottom.primitives.size();
+      bottom.nodes[index].count[slot] = primitives.size();
+      bottom.primitives.insert(end(bottom.primitives), begin(primitives),
+                               end(primitives));
+      continue;
+    }
+
+    vector<aabb3> boxes(primitives.size());
+    for (size_t i = 0; i < primitives.size(); ++i)
+      boxes[i] = face_box(surface, primitives[i]);
+    auto subtree = bvh_from(boxes);
+    for (auto& p : subtree.primitives) p = primitives[p];
+    const auto graft = wide_bvh_from(move(subtree));
+
+    const auto node_offset = bottom.nodes.size();
+    const auto primitive_offset = bottom.primitives.size();
+    for (auto node : graft.nodes) {
+      for (size_t i = 0; i < wide_bvh::width; ++i)
+        if (!node.empty(i))
+          node.child[i] += node.leaf(i) ? primitive_offset : node_offset;
+      bottom.nodes.push_back(node);
+    }
+    bottom.primitives.insert(end(bottom.primitives), begin(graft.primitives),
+                             end(graft.primitives));
+    bottom.nodes[index].child[slot] = node_offset;
+    bottom.nodes[index].count[slot] = 0;
+  }
+
+  if (tree.cached()) {
+    auto& triangles = tree.triangles[cid];
+    for (auto i = first; i < bottom.primitives.size(); ++i)
+      triangles.push_back(triangle(surface, bottom.primitives[i]));
+  }
+  return true;
+}
+
+auto top_level_from(const vector<wide_bvh>& components) -> bvh {
+  vector<aabb3> boxes(components.size());
+  for (size_t cid = 0; cid < components.size(); ++cid)
+    boxes[cid] = components[cid].box();
+  return bvh_from(boxes, 1);
+}
+
+}  // namespace
+
+void surface_bvh::update(const polyhedral_surface& surface,
+                         component_id cid) {
+  const bool added = cid >= components.size();
+  if (added) {
+    components.resize(cid + 1);
+    hidden.resize(cid + 1, false);
+    if (cached()) triangles.resize(cid + 1);
+  }
+  components[cid] = component_bvh_from(surface, cid);
+  if (cached()) triangles[cid] = triangles_from(surface, components[cid]);
+  if (added)
+    top = top_level_from(components);
+  else
+    refit(top, [&](component_id c) { return components[c].box(); });
+}
+
+void surface_bvh::update(const polyhedral_surface& surface,
+                         component_id cid,
+                         span<const face_id> changed,
+                         size_t face_count) {
+  const auto old_count = components.size();
+  const auto count = surface.component_count();
+
+  // Faces moved to split off components have not changed their shape.
+  // Only pieces of this cut can be new.
+  //
+  vector<face_id> removed(begin(changed), end(changed));
+  for (auto c = old_count; c < count; ++c)
+    for (auto fid : surface.component_face_ids(c))
+      if (fid < face_count) removed.push_back(fid);
+  ranges::sort(removed);
+  removed.erase(ranges::unique(removed).begin(), end(removed));
+  vector<face_id> inserted{};
+  for (auto fid : removed)
+    if (surface.component(fid) == cid) inserted.push_back(fid);
+  for (auto fid = face_count; fid < surface.faces.size(); ++fid)
+    if (surface.component(fid) == cid) inserted.push_back(fid);
+
+  if (!update_leaves(*this, surface, cid, removed, inserted)) {
+    components[cid] = component_bvh_from(surface, cid);
+    if (cached()) triangles[cid] = triangles_from(surface, components[cid]);
+  }
+
+  components.resize(count);
+  hidden.resize(count, false);
+  if (cached()) triangles.resize(count);
+  for (auto c = old_count; c < count; ++c) {
+    components[c] = component_bvh_from(surface, c);
+    if (cached()) triangles[c] = triangles_from(surface, components[c]);
+  }
+  if (count != old_count)
+    top = top_level_from(components);
+  else
+    refit(top, [&](component_id c) { return components[c].box(); });
+}
+
+void surface_bvh::cache_triangles(const polyhedral_surface& surface) {
+  triangles.resize(components.size());
+  parallel_for(
+      0, components.size(),
+      [&](size_t cid) {
+        triangles[cid] = triangles_from(surface, components[cid]);
+      },
+      1);
+}
+
+auto surface_bvh::memory_usage() const noexcept -> size_t {
+  auto result = top.memory_usage();
+  for (const auto& component : components) result += component.memory_usage();
+  for (const auto& t : triangles) result += t.size() * sizeof(cached_triangle);
+  return result;
+}
+
+auto surface_bvh_from(const polyhedral_surface& surface) -> surface_bvh {
+  surface_bvh result{};
+  if (surface.faces.empty()) return result;
+
+  const auto count = surface.component_count();
+  result.components.resize(count);
+  result.hidden.assign(count, false);
+
+  // Components are independent of each other.
+  // Their bottom levels can be built in parallel.
+  //
+  parallel_for(
+      0, count,
+      [&](size_t cid) {
+        result.components[cid] = component_bvh_from(surface, cid);
+      },
+      1);
+
+  result.top = top_level_from(result.components);
+
+  return result;
+}
+
+}  // namespace nanoreflex
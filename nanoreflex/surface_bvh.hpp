@@ -0,0 +1,96 @@
+#pragma once
+#include <nanoreflex/wide_bvh.hpp>
+#include <nanoreflex/polyhedral_surface.hpp>
+
+namespace nanoreflex {
+
+/// Two-level acceleration structure for polyhedral surfaces.
+/// Every component of the surface gets its own compressed bottom-level
+/// hierarchy over its faces and a small top-level hierarchy is built
+/// over the bounding boxes of all components.
+/// Hiding, moving, or reloading a single component
+/// therefore only touches its own hierarchy and the top level.
+///
+struct surface_bvh {
+  using face_id = polyhedral_surface::face_id;
+  using component_id = polyhedral_surface::component_id;
+
+  /// Triangle given by its first vertex and its two outgoing edges.
+  /// This is exactly the data needed for ray-triangle intersections.
+  ///
+  struct cached_triangle {
+    vec3 origin;
+    vec3 edge1;
+    vec3 edge2;
+  };
+
+  auto component_count() const noexcept { return components.size(); }
+
+  /// The optional triangle cache stores all faces of a component
+  /// contiguously in the primitive order of its bottom level.
+  /// Leaves then read their triangles without gathering vertices
+  /// through face indices for the price of 36 bytes per face.
+  ///
+  bool cached() const noexcept { return !triangles.empty(); }
+  void cache_triangles(const polyhedral_surface& surface);
+  void clear_triangle_cache() noexcept { triangles = {}; }
+
+  bool visible(component_id cid) const noexcept { return !hidden[cid]; }
+  void hide(component_id cid) noexcept { hidden[cid] = true; }
+  void show(component_id cid) noexcept { hidden[cid] = false; }
+
+  /// Rebuild the bottom-level hierarchy of the given component
+  /// after its vertices have been moved or reloaded
+  /// and adjust the top level to its new bounding box.
+  /// New components are appended
+  /// and only then the small top level is built again.
+  ///
+  void update(const polyhedral_surface& surface, component_id cid);
+
+  /// Update the hierarchy after the given component has been cut.
+  /// The changed faces keep their ID but have been split
+  /// and all faces from 'face_count' on are new pieces.
+  /// Pieces lie inside the faces they were cut from.
+  /// So, all boxes stay valid and only the leaves of changed faces
+  /// and faces moved to split off components are replaced.
+  /// Split off components get their own bottom level.
+  /// The component is only rebuilt if a face cannot be found
+  /// inside the boxes, for example due to rounding,
+  /// or if the replaced leaves outweigh the kept ones.
+  ///
+  void update(const polyhedral_surface& surface,
+              component_id cid,
+              span<const face_id> changed,
+              size_t face_count);
+
+  auto memory_usage() const noexcept -> size_t;
+
+  // The primitives of the bottom levels are face IDs.
+  vector<wide_bvh> components{};
+  // The primitives of the top level are component IDs.
+  bvh top{};
+  vector<bool> hidden{};
+  // Cached triangles per component or empty if disabled.
+  vector<vector<cached_triangle>> triangles{};
+};
+
+/// Construct the two-level hierarchy for all components of the surface.
+/// The topological structure of the surface needs to be generated before.
+///
+auto surface_bvh_from(const polyhedral_surface& surface) -> surface_bvh;
+
+/// Call 'process(face_ids)' for every bottom-level leaf
+/// of a visible component whose boxes in both levels fulfill 'accept(box)'.
+///
+inline void for_each_leaf(const surface_bvh& tree,
+                          auto&& accept,
+                          auto&& process) {
+  for_each_leaf(tree.top, accept, [&](auto cids) {
+    for (auto cid : cids) {
+      if (!tree.visible(cid)) continue;
+      for_each_leaf(tree.components[cid], accept, process);
+    }
+  });
+}
+
+}  // namespace nanoreflex
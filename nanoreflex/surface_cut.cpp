@@ -0,0 +1,287 @@
+#include <nanoreflex/polyhedral_surface.hpp>
+
+namespace nanoreflex {
+
+void polyhedral_surface::cut(const surface_mesh_curve& curve) {
+  if (!valid(curve) || (curve.size() == 0))
+    throw runtime_error("Failed to cut surface along an invalid curve.");
+  const logging::scope total{"cut"};
+
+  const auto& strip = curve.face_strip;
+  const bool closed = curve.closed();
+  const auto m = curve.size();
+  const auto face_count = faces.size();
+
+  // Location of the edge of a strip face shared with its successor.
+  //
+  const auto exit = [&](size_t k) {
+    const auto f = strip[k + 1];
+    return face_adjacencies[f >> 2][f & 0b11] & 0b11;
+  };
+
+  // Every split face is entered and left through crossed edges
+  // with the indices of their curve points.
+  // The first and last face of open curves contain the end points
+  // and are only crossed once.
+  //
+  struct split {
+    face_id fid;
+    uint32 in;
+    uint32 out;
+    uint32 p;
+    uint32 q;
+  };
+  vector<split> splits{};
+  if (!closed) splits.push_back({strip[0] >> 2, invalid, exit(0), invalid, 0});
+  const auto middle = closed ? m : m - 1;
+  for (size_t k = 0; k < middle; ++k) {
+    const auto next = (k + 1) % m;
+    splits.push_back({strip[k + 1] >> 2, strip[k + 1] & 0b11,
+                      uint32(exit(next)), uint32(k), uint32(next)});
+  }
+  if (!closed) splits.push_back({strip[m] >> 2, strip[m] & 0b11, invalid,
+                                 uint32(m - 1), invalid});
+
+  vector<face_id> split_faces(splits.size());
+  for (size_t i = 0; i < splits.size(); ++i) split_faces[i] = splits[i].fid;
+  ranges::sort(split_faces);
+  if (ranges::adjacent_find(split_faces) != end(split_faces))
+    throw runtime_error(
+        "Failed to cut surface along a curve that visits a face twice.");
+  for (const auto& s : splits)
+    if (s.in == s.out)
+      throw runtime_error(
+          "Failed to cut surface along a curve that leaves a face through "
+          "the edge it entered.");
+
+  // Faces around the strip only change their adjacencies.
+  //
+  vector<uint32> neighbors{};
+  for (const auto& s : splits)
+    for (auto a : face_adjacencies[s.fid])
+      if ((a != invalid) && !ranges::binary_search(split_faces, a >> 2))
+        neighbors.push_back(a);
+
+  // Every curve point gets a vertex for the side of each end of its edge.
+  // Faces choose the copy by the end that lies on their side.
+  // Weights at the ends of an edge would collapse faces
+  // and are moved slightly inwards.
+  //
+  constexpr real epsilon = 1e-3f;
+  struct cut_point {
+    edge e;
+    array<vertex_id, 2> copies;
+  };
+  vector<cut_point> points(m);
+  const auto add_vertex = [&](const vertex& v) {
+    vertices.push_back(v);
+    topological_vertex_map.push_back();
+    return vertex_id(vertices.size() - 1);
+  };
+  for (size_t k = 0; k < m; ++k) {
+    auto& x = points[k];
+    x.e = face_edge(strip[k + 1]);
+    const auto t = clamp(curve.edge_weights[k], epsilon, real(1) - epsilon);
+    const vertex v{position(x.e, t), normalize((real(1) - t) * normal(x.e[0]) +
+                                               t * normal(x.e[1]))};
+    x.copies[0] = add_vertex(v);
+    const bool end_point = !closed && ((k == 0) || (k == m - 1));
+    x.copies[1] = end_point ? x.copies[0] : add_vertex(v);
+  }
+  const auto copy = [&](uint32 k, vertex_id vid) {
+    const auto& x = points[k];
+    return x.copies[topological_vertex(vid) != topological_vertex(x.e[0])];
+  };
+
+  // Remove the split faces from their edges.
+  //
+  const auto edge_key = [&](face_id fid, uint32 loc) {
+    const auto& f = faces[fid];
+    return edge{topological_vertex(f[loc]),
+                topological_vertex(f[(loc + 1) % 3])};
+  };
+  for (const auto& s : splits) {
+    for (uint32 l = 0; l < 3; ++l) {
+      const auto it = edges.find(edge_key(s.fid, l));
+      if (it == end(edges)) continue;
+      auto& info = it->second;
+      if ((info.face[1] == s.fid) && (info.location[1] == l))
+        info.face[1] = invalid;
+      else if ((info.face[0] == s.fid) && (info.location[0] == l)) {
+        info.face[0] = info.face[1];
+        info.location[0] = info.location[1];
+        info.face[1] = invalid;
+      }
+      if (info.face[0] == invalid) edges.erase(it);
+    }
+  }
+
+  // Split faces keep their ID for their first piece
+  // and all other pieces are appended.
+  // Quads are split along their shorter diagonal.
+  //
+  vector<face_id> changed{};
+  vector<face_id> origins{};
+  array<face_id, 2> seeds{};
+  const auto quad = [&](vertex_id a, vertex_id b, vertex_id c, vertex_id d) {
+    if (distance(position(a), position(c)) <=
+        distance(position(b), position(d)))
+      return array<face, 2>{face{a, b, c}, face{a, c, d}};
+    return array<face, 2>{face{a, b, d}, face{b, c, d}};
+  };
+  for (const auto& s : splits) {
+    const auto f = faces[s.fid];
+    vector<face> pieces{};
+    if ((s.in == invalid) || (s.out == invalid)) {
+      const auto l = (s.in == invalid) ? s.out : s.in;
+      const auto x = points[(s.in == invalid) ? s.q : s.p].copies[0];
+      pieces = {face{f[l], x, f[(l + 2) % 3]},
+                face{x, f[(l + 1) % 3], f[(l + 2) % 3]}};
+    } else {
+      // Entering through the edge from 'a' to 'b',
+      // the curve cuts off the corner 'b' or 'a'
+      // depending on the edge it leaves through.
+      //
+      const auto a = f[s.in];
+      const auto b = f[(s.in + 1) % 3];
+      const auto c = f[(s.in + 2) % 3];
+      array<face, 2> rest{};
+      if ((s.in + 1) % 3 == s.out) {
+        pieces.push_back(face{copy(s.p, b), b, copy(s.q, b)});
+        rest = quad(a, copy(s.p, a), copy(s.q, c), c);
+      } else {
+        pieces.push_back(face{a, copy(s.p, a), copy(s.q, a)});
+        rest = quad(copy(s.p, b), b, c, copy(s.q, c));
+      }
+      pieces.insert(end(pieces), begin(rest), end(rest));
+    }
+    faces[s.fid] = pieces[0];
+    changed.push_back(s.fid);
+    for (size_t i = 1; i < pieces.size(); ++i) {
+      faces.push_back(pieces[i]);
+      origins.push_back(s.fid);
+      changed.push_back(faces.size() - 1);
+    }
+  }
+  // The corner and quad pieces of the first split lie on different sides.
+  if (closed) seeds = {splits[0].fid, face_id(face_count)};
+
+  for (auto fid : changed)
+    for (uint32 l = 0; l < 3; ++l) edges[edge_key(fid, l)].add_face(fid, l);
+
+  // Face adjacencies are looked up
+  // as done by 'generate_face_adjacencies' for a single edge.
+  //
+  const auto adjacency = [&](face_id fid, uint32 loc) -> uint32 {
+    const auto e = edge_key(fid, loc);
+    const auto& info = edges.at(e);
+    if (!info.oriented()) {
+      const size_t i =
+          ((info.face[0] == fid) && (info.location[0] == loc)) ? 1 : 0;
+      return uint32(info.face[i] << 2) | uint32(info.location[i]);
+    }
+    const auto it = edges.find(edge{e[1], e[0]});
+    if (it == end(edges)) return invalid;
+    const auto& info2 = it->second;
+    return uint32(info2.face[0] << 2) | uint32(info2.location[0]);
+  };
+  face_adjacencies.resize(faces.size());
+  for (auto fid : changed)
+    for (uint32 l = 0; l < 3; ++l) face_adjacencies[fid][l] = adjacency(fid, l);
+  for (auto a : neighbors)
+    face_adjacencies[a >> 2][a & 0b11] = adjacency(a >> 2, a & 0b11);
+
+  face_barycenters.resize(faces.size());
+  face_adjacency_weights.resize(faces.size());
+  corner_angles.resize(faces.size());
+  for (auto fid : changed) {
+    face_barycenters[fid] = barycenter(fid);
+    update_corner_angles(fid);
+  }
+  const auto update_weight = [&](face_id fid, uint32 loc) {
+    const auto n = face_adjacencies[fid][loc];
+    face_adjacency_weights[fid][loc] =
+        (n == invalid)
+            ? infinity
+            : distance(face_barycenters[fid], face_barycenters[n >> 2]);
+  };
+  for (auto fid : changed)
+    for (uint32 l = 0; l < 3; ++l) update_weight(fid, l);
+  for (auto a : neighbors) update_weight(a >> 2, a & 0b11);
+
+  // Only vertices of changed faces change their curvature.
+  // Their corners are gathered by rotating around them
+  // over the face adjacencies in both directions.
+  //
+  angle_defects.resize(topological_vertex_count());
+  mean_curvature_normals.resize(topological_vertex_count());
+  vector<pair<vertex_id, uint32>> vertex_corners{};
+  for (auto fid : changed)
+    for (uint32 i = 0; i < 3; ++i)
+      vertex_corners.push_back(
+          {topological_vertex(faces[fid][i]), 3 * fid + i});
+  ranges::sort(vertex_corners);
+  vector<uint32> corners{};
+  for (size_t k = 0; k < vertex_corners.size(); ++k) {
+    const auto v = vertex_corners[k].first;
+    const auto corner = vertex_corners[k].second;
+    if ((k > 0) && (vertex_corners[k - 1].first == v)) continue;
+    const auto start = corner / 3;
+    const auto walk = [&](uint32 loc) {
+      auto fid = start;
+      while (corners.size() <= faces.size()) {
+        const auto a = face_adjacencies[fid][loc];
+        if (a == invalid) return false;
+        fid = a >> 2;
+        if (fid == start) return true;
+        const auto j = a & 0b11;
+        const auto i =
+            (topological_vertex(faces[fid][j]) == v) ? j : (j + 1) % 3;
+        corners.push_back(3 * fid + i);
+        loc = (j == i) ? (i + 2) % 3 : i;
+      }
+      return true;
+    };
+    corners.assign(1, corner);
+    if (!walk(corner % 3)) walk((corner + 2) % 3);
+    update_vertex_curvature(v, corners);
+  }
+
+  // Pieces join the component of their face.
+  // A closed curve may separate its component.
+  // Both sides are searched alternately from the first split face.
+  // If one search runs out of faces, only its side is moved
+  // to a new component and so only the smaller side is traversed.
+  // Otherwise, both searches meet
+  // which for non-separating curves may take the whole component.
+  //
+  for (auto fid : origins) face_component_map.push_back(component(fid));
+  if (closed) {
+    array<vector<face_id>, 2> queues{vector{seeds[0]}, vector{seeds[1]}};
+    unordered_map<face_id, uint32> sides{{seeds[0], 0}, {seeds[1], 1}};
+    const auto separated = [&]() -> int {
+      array<size_t, 2> heads{};
+      while (true) {
+        for (uint32 s = 0; s < 2; ++s) {
+          if (heads[s] == queues[s].size()) return s;
+          const auto fid = queues[s][heads[s]++];
+          for (auto a : face_adjacencies[fid]) {
+            if (a == invalid) continue;
+            const auto [it, inserted] = sides.emplace(a >> 2, s);
+            if (inserted)
+              queues[s].push_back(a >> 2);
+            else if (it->second != s)
+              return -1;
+          }
+        }
+      }
+    }();
+    if (separated >= 0) {
+      const auto c = face_component_map.add_class();
+      for (auto fid : queues[separated]) face_component_map.relabel(fid, c);
+    }
+  }
+  assert(face_component_map.domain_size() == faces.size());
+}
+
+}  // namespace nanoreflex
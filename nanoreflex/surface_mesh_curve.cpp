@@ -1,8 +1,27 @@
+#include <nanoreflex/face_search.hpp>
+#include <nanoreflex/log.hpp>
+#include <nanoreflex/parallel.hpp>
 #include <nanoreflex/polyhedral_surface.hpp>
 #include <nanoreflex/surface_mesh_curve.hpp>
 
 namespace nanoreflex {
 
+namespace {
+
+// Deferred formatting of face strips for trace messages.
+// Nothing is formatted if tracing is disabled.
+//
+struct face_strip_format {
+  friend auto operator<<(ostream& os, const face_strip_format& x)
+      -> ostream& {
+    for (auto f : x.strip) os << '(' << (f >> 2) << ',' << (f & 0b11) << ')';
+    return os;
+  }
+  span<const uint32> strip;
+};
+
+}  // namespace
+
 bool polyhedral_surface::valid(const surface_mesh_curve& curve) const noexcept {
   if (curve.face_strip.size() != curve.edge_weights.size() + 1) return false;
 
@@ -21,105 +40,573 @@ bool polyhedral_surface::valid(const surface_mesh_curve& curve) const noexcept {
 auto polyhedral_surface::points_from(const surface_mesh_curve& curve) const
     -> vector<vec3> {
   vector<vec3> points{};
-  for (size_t i = 0; i < curve.size(); ++i) {
-    const auto f1 = curve.face_strip[i];
-    const auto f2 = curve.face_strip[i + 1];
-    const auto fid = f2 >> 2;
-    const auto loc = f2 & 0b11;
-    points.push_back(position(edge{faces[fid][loc], faces[fid][(loc + 1) % 3]},
-                              curve.edge_weights[i]));
-  }
+  update_points(curve, 0, points);
   return points;
 }
 
-auto polyhedral_surface::shortest_surface_mesh_curve(face_id src,
-                                                     face_id dst) const
-    -> surface_mesh_curve {
-  const auto barycenter = [&](face_id fid) {
-    const auto& f = faces[fid];
-    return (vertices[f[0]].position + vertices[f[1]].position +
-            vertices[f[2]].position) /
-           3.0f;
-  };
-  const auto face_distance = [&](face_id i, face_id j) {
-    return glm::distance(barycenter(i), barycenter(j));
+void polyhedral_surface::update_points(const surface_mesh_curve& curve,
+                                       size_t first,
+                                       vector<vec3>& points) const {
+  // Every face of the strip already stores the location
+  // of its edge shared with the previous face.
+  // So, long strips are processed by a plain parallel gather.
+  //
+  points.resize(curve.size());
+  parallel_for(
+      first, points.size(),
+      [&](size_t i) {
+        points[i] = position(face_edge(curve.face_strip[i + 1]),
+                             curve.edge_weights[i]);
+      },
+      4096);
+}
+
+auto polyhedral_surface::arc_lengths(const surface_mesh_curve& curve) const
+    -> vector<float32> {
+  const auto points = points_from(curve);
+  vector<float32> result(points.size(), 0);
+  parallel_for(
+      1, points.size(),
+      [&](size_t i) { result[i] = distance(points[i - 1], points[i]); },
+      4096);
+  parallel_inclusive_scan(span(result));
+  return result;
+}
+
+namespace {
+
+// Barycentric coordinates of the point of edge 'i' of the curve
+// in the face 'face_strip[i + 1]' or, if 'next' is true,
+// in the face 'face_strip[i]' which precedes its edge.
+//
+auto edge_point_coordinates(const polyhedral_surface& surface,
+                            const polyhedral_surface::surface_mesh_curve& curve,
+                            size_t i,
+                            bool next) -> vec3 {
+  auto f = curve.face_strip[i + 1];
+  auto w = curve.edge_weights[i];
+  if (next) {
+    const auto g = surface.face_adjacencies[f >> 2][f & 0b11];
+    // The shared edge may be oriented differently in the other face.
+    const auto e = surface.face_edge(f);
+    if (surface.topological_vertex(surface.faces[g >> 2][g & 0b11]) !=
+        surface.topological_vertex(e[0]))
+      w = 1 - w;
+    f = g;
+  }
+  const auto loc = f & 0b11;
+  vec3 result{};
+  result[loc] = 1 - w;
+  result[(loc + 1) % 3] = w;
+  return result;
+}
+
+// Sample the polygon of a curve at the given arc lengths.
+// Every sample is found by a binary search in the cumulative arc lengths.
+// So, all samples are computed independently in parallel.
+//
+auto samples_from(const polyhedral_surface& surface,
+                  const polyhedral_surface::surface_mesh_curve& curve,
+                  const vector<float32>& lengths,
+                  size_t count,
+                  auto&& arc_length) {
+  using face_point = polyhedral_surface::face_point;
+  vector<face_point> result(count);
+  const auto m = lengths.size();
+  if (m == 0) return vector<face_point>{};
+
+  const auto barycentric = [&](size_t i, bool next) {
+    return edge_point_coordinates(surface, curve, i, next);
   };
 
-  vector<bool> visited(faces.size(), false);
+  parallel_for(
+      0, count,
+      [&](size_t j) {
+        const auto s = std::clamp(arc_length(j), 0.0f, lengths.back());
+        if (m == 1) {
+          const auto b = barycentric(0, false);
+          result[j] = {curve.face_strip[1] >> 2, b[1], b[2]};
+          return;
+        }
+        // Segment 'k' connects the points of the edges 'k' and 'k + 1'
+        // inside the face 'face_strip[k + 1]'.
+        const auto k = std::min(
+            size_t(ranges::upper_bound(lengths, s) - begin(lengths)) - 1,
+            m - 2);
+        const auto d = lengths[k + 1] - lengths[k];
+        const auto t = (d > 0) ? (s - lengths[k]) / d : 0.0f;
+        const auto b =
+            (1 - t) * barycentric(k, false) + t * barycentric(k + 1, true);
+        result[j] = {curve.face_strip[k + 1] >> 2, b[1], b[2]};
+      },
+      4096);
+  return result;
+}
+
+}  // namespace
+
+auto polyhedral_surface::resample(const surface_mesh_curve& curve,
+                                  size_t count) const -> vector<face_point> {
+  const auto lengths = arc_lengths(curve);
+  if (lengths.empty()) return {};
+  const auto length = lengths.back();
+  const auto step = (count > 1) ? length / (count - 1) : 0.0f;
+  // The last sample is set exactly to avoid rounding beyond the end.
+  return samples_from(*this, curve, lengths, count, [&](size_t j) {
+    return (j + 1 == count) ? length : j * step;
+  });
+}
+
+auto polyhedral_surface::resample_with_spacing(const surface_mesh_curve& curve,
+                                               float32 spacing) const
+    -> vector<face_point> {
+  const auto lengths = arc_lengths(curve);
+  if (lengths.empty()) return {};
+  const auto length = lengths.back();
+  if (!(spacing > 0)) return resample(curve, 1);
+  const auto full = size_t(length / spacing);
+  const auto count = full + 1 + ((full * spacing < length) ? 1 : 0);
+  return samples_from(*this, curve, lengths, count, [&](size_t j) {
+    return (j + 1 == count) ? length : j * spacing;
+  });
+}
+
+auto polyhedral_surface::crossings(span<const surface_mesh_curve> curves) const
+    -> vector<curve_crossing> {
+  const auto segment_count = [](const surface_mesh_curve& curve) -> size_t {
+    const auto m = curve.size();
+    if (m < 2) return 0;
+    return m - 1 + (curve.closed() ? 1 : 0);
+  };
+  vector<size_t> offsets(curves.size() + 1, 0);
+  for (size_t c = 0; c < curves.size(); ++c)
+    offsets[c + 1] = offsets[c] + segment_count(curves[c]);
+
+  // Every segment stores its end points in barycentric coordinates
+  // of its face which reduces all tests to the plane.
+  //
+  struct segment {
+    face_id face;
+    uint32 curve;
+    uint32 index;
+    vec2 start;
+    vec2 end;
+  };
+  vector<segment> segments(offsets.back());
+  parallel_for(0, segments.size(), [&](size_t i) {
+    const auto c = size_t(ranges::upper_bound(offsets, i) - begin(offsets)) - 1;
+    const auto& curve = curves[c];
+    const auto k = i - offsets[c];
+    const auto m = curve.size();
+    const auto closing = (k == m - 1);
+    const auto first = closing ? m - 1 : k;
+    const auto last = closing ? 0 : k + 1;
+    const auto a = edge_point_coordinates(*this, curve, first, false);
+    const auto b = edge_point_coordinates(*this, curve, last, true);
+    segments[i] = {curve.face_strip[first + 1] >> 2, uint32(c), uint32(k),
+                   {a[1], a[2]}, {b[1], b[2]}};
+  });
+  ranges::sort(segments, {}, [](const segment& x) {
+    return tuple{x.face, x.curve, x.index};
+  });
+
+  vector<size_t> buckets{};
+  for (size_t i = 0; i < segments.size(); ++i)
+    if ((i == 0) || (segments[i].face != segments[i - 1].face))
+      buckets.push_back(i);
+  buckets.push_back(segments.size());
+
+  // Neighboring segments of a curve always share an end point.
+  //
+  const auto neighbors = [&](const segment& x, const segment& y) {
+    if (x.curve != y.curve) return false;
+    const auto n = segment_count(curves[x.curve]);
+    const auto d = (y.index + n - x.index) % n;
+    return curves[x.curve].closed() ? ((d == 1) || (d == n - 1))
+                                    : ((x.index + 1 == y.index) ||
+                                       (y.index + 1 == x.index));
+  };
+  const auto cross = [](vec2 x, vec2 y) { return x.x * y.y - x.y * y.x; };
+
+  vector<curve_crossing> result{};
+  mutex result_mutex{};
+  parallel_for_chunks(0, buckets.size() - 1, [&](size_t first, size_t last) {
+    vector<curve_crossing> local{};
+    for (auto b = first; b < last; ++b) {
+      for (auto i = buckets[b]; i < buckets[b + 1]; ++i) {
+        for (auto j = i + 1; j < buckets[b + 1]; ++j) {
+          const auto& x = segments[i];
+          const auto& y = segments[j];
+          if (neighbors(x, y)) continue;
+          const auto u = x.end - x.start;
+          const auto v = y.end - y.start;
+          const auto w = y.start - x.start;
+          const auto d = cross(u, v);
+          if (d == 0) continue;
+          const auto s = cross(w, v) / d;
+          const auto t = cross(w, u) / d;
+          if ((s < 0) || (s > 1) || (t < 0) || (t > 1)) continue;
+          const auto p = x.start + s * u;
+          local.push_back({{x.curve, y.curve}, {x.index, y.index},
+                           {x.face, p.x, p.y}});
+        }
+      }
+    }
+    scoped_lock lock{result_mutex};
+    result.insert(end(result), begin(local), end(local));
+  });
+  ranges::sort(result, {}, [](const curve_crossing& x) {
+    return pair{x.curves, x.segments};
+  });
+  return result;
+}
 
-  vector<float> distances(faces.size(), INFINITY);
-  distances[src] = 0;
+auto polyhedral_surface::self_intersections(
+    const surface_mesh_curve& curve) const -> vector<curve_crossing> {
+  return crossings(span(&curve, 1));
+}
 
-  vector<uint32> previous(faces.size());
-  previous[src] = src;
+bool polyhedral_surface::simple(const surface_mesh_curve& curve) const {
+  return self_intersections(curve).empty();
+}
 
-  vector<uint32> queue{src};
-  const auto order = [&](uint32 i, uint32 j) {
-    return distances[i] > distances[j];
+auto polyhedral_surface::region_from(const surface_mesh_curve& curve,
+                                     bool left) const -> vector<bool> {
+  const auto n = faces.size();
+  vector<bool> result(n, false);
+  if (!curve.closed()) return result;
+
+  // Position 'p' of the cyclic strip is the face 'face_strip[p + 1]'.
+  // The last entry repeats the first face and so closes the cycle.
+  //
+  const auto m = curve.face_strip.size() - 1;
+  const auto next = [&](size_t p) { return (p + 1) % m; };
+  const auto position_face = [&](size_t p) {
+    return curve.face_strip[p + 1] >> 2;
+  };
+  const auto entry = [&](size_t p) { return curve.face_strip[p + 1] & 0b11; };
+  const auto exit = [&](size_t p) {
+    const auto f = curve.face_strip[next(p) + 1];
+    return face_adjacencies[f >> 2][f & 0b11] & 0b11;
   };
 
-  do {
-    ranges::make_heap(queue, order);
-    ranges::pop_heap(queue, order);
-    const auto current = queue.back();
-    queue.pop_back();
+  // Nodes of the search are all faces and two pieces per strip position.
+  // Entering a face through an edge, its first vertex lies on the left.
+  // So, the free edge is on the left if the curve turns right.
+  // Neighboring faces may be oriented differently
+  // which swaps their sides.
+  //
+  const auto piece = [&](size_t p, bool l) { return uint32(n + 2 * p + !l); };
+  vector<uint32> free_edges(m);
+  vector<bool> free_left(m);
+  vector<bool> swapped(m);
+  vector<bool> strip(n, false);
+  unordered_map<uint32, uint32> free_edge_pieces{};
+  for (size_t p = 0; p < m; ++p) {
+    const auto fid = position_face(p);
+    const auto in = entry(p);
+    const auto out = exit(p);
+    const auto step = (3 + out - in) % 3;
+    free_edges[p] = (in + 3 - step) % 3;
+    free_left[p] = (step == 1);
+    const auto& f = faces[fid];
+    const auto& g = faces[position_face(next(p))];
+    swapped[p] = topological_vertex(f[(out + 1) % 3]) !=
+                 topological_vertex(g[entry(next(p))]);
+    if (strip[fid])
+      throw runtime_error(
+          "Failed to extract region of a curve that visits a face twice.");
+    strip[fid] = true;
+    free_edge_pieces.emplace((fid << 2) | free_edges[p],
+                             piece(p, free_left[p]));
+  }
 
-    // cout << "current = " << current << endl;
+  const auto adjacent = [&](uint32 a, auto&& visit) {
+    if (a == invalid) return;
+    if (!strip[a >> 2]) {
+      visit(a >> 2);
+      return;
+    }
+    const auto it = free_edge_pieces.find(a);
+    if (it != end(free_edge_pieces)) visit(it->second);
+  };
+  const auto neighbors = [&](uint32 x, auto&& visit) {
+    if (x < n) {
+      for (auto a : face_adjacencies[x]) adjacent(a, visit);
+      return;
+    }
+    const auto p = (x - n) / 2;
+    const bool l = ((x - n) % 2) == 0;
+    const auto q = (p + m - 1) % m;
+    visit(piece(next(p), l != swapped[p]));
+    visit(piece(q, l != swapped[q]));
+    if (l == free_left[p])
+      adjacent(face_adjacencies[position_face(p)][free_edges[p]], visit);
+  };
 
-    visited[current] = true;
+  // Level-synchronous breadth-first search.
+  // Nodes are claimed atomically so every node enters the frontier once.
+  // Only the first piece is seeded as the pieces of one side
+  // are chained along the strip with respect to swapped orientations.
+  //
+  vector<atomic<bool>> visited(n + 2 * m);
+  vector<uint32> frontier{piece(0, left)};
+  visited[frontier[0]] = true;
+  vector<uint32> next_frontier{};
+  mutex frontier_mutex{};
+  while (!frontier.empty()) {
+    next_frontier.clear();
+    parallel_for_chunks(0, frontier.size(), [&](size_t first, size_t last) {
+      vector<uint32> local{};
+      for (auto i = first; i < last; ++i)
+        neighbors(frontier[i], [&](uint32 y) {
+          if (visited[y].load(memory_order_relaxed)) return;
+          if (visited[y].exchange(true, memory_order_relaxed)) return;
+          local.push_back(y);
+        });
+      scoped_lock lock{frontier_mutex};
+      next_frontier.insert(end(next_frontier), begin(local), end(local));
+    });
+    swap(frontier, next_frontier);
+  }
 
-    const auto neighbor_faces = face_adjacencies[current];
-    for (int i = 0; i < 3; ++i) {
-      const auto n = neighbor_faces[i];
-      if (n == invalid) continue;
-      const auto neighbor = (n >> 2);
-      const auto loc = n & 0b11;
-      if (visited[neighbor]) continue;
+  for (size_t fid = 0; fid < n; ++fid)
+    if (!strip[fid] && visited[fid].load(memory_order_relaxed))
+      result[fid] = true;
+  for (size_t p = 0; p < m; ++p)
+    if (visited[piece(p, free_left[p])].load(memory_order_relaxed))
+      result[position_face(p)] = true;
+  return result;
+}
 
-      const auto d = face_distance(current, neighbor) + distances[current];
-      if (d >= distances[neighbor]) continue;
+void polyhedral_surface::straighten(surface_mesh_curve& curve) const {
+  // The face strip is unfolded into the plane face by face.
+  // Every face stores its topological vertices with planar positions.
+  // The first and last face contain the barycentric end points
+  // and every edge between consecutive faces is a portal of the path.
+  //
+  if (curve.face_strip.size() < 2) return;
+  const auto m = curve.size();
+
+  struct point {
+    vec2 position;
+    vertex_id id = invalid;
+  };
+  const auto cross = [](vec2 a, vec2 b, vec2 c) {
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+  };
 
-      distances[neighbor] = d;
-      // previous[neighbor] = (current << 2) | uint32(i);
-      previous[neighbor] = loc;
-      queue.push_back(neighbor);
+  array<point, 3> unfolded{};
+  {
+    const auto& f = faces[curve.face_strip.front() >> 2];
+    const auto p0 = position(f[0]);
+    const auto p1 = position(f[1]);
+    const auto p2 = position(f[2]);
+    const auto e = normalize(p1 - p0);
+    const auto x = dot(p2 - p0, e);
+    const auto y = length(p2 - p0 - x * e);
+    unfolded = {point{{0, 0}, topological_vertex(f[0])},
+                point{{length(p1 - p0), 0}, topological_vertex(f[1])},
+                point{{x, y}, topological_vertex(f[2])}};
+  }
+  const auto barycenter = [&] {
+    return (unfolded[0].position + unfolded[1].position +
+            unfolded[2].position) /
+           3.0f;
+  };
+  const auto src = barycenter();
+
+  // Portals are stored with their left and right end points
+  // in the direction of the strip.
+  // 'flipped' marks portals whose left end is the second edge vertex.
+  //
+  vector<array<point, 2>> portals(m);
+  vector<bool> flipped(m);
+  for (size_t i = 0; i < m; ++i) {
+    const auto f = curve.face_strip[i + 1];
+    const auto& face = faces[f >> 2];
+    const auto loc = f & 0b11;
+    const auto a = face[loc];
+    const auto b = face[(loc + 1) % 3];
+    const auto c = face[(loc + 2) % 3];
+    const auto ta = topological_vertex(a);
+    const auto tb = topological_vertex(b);
+    const auto find = [&](vertex_id id) {
+      for (size_t k = 0; k < 3; ++k)
+        if (unfolded[k].id == id) return k;
+      assert(false);
+      return size_t{};
+    };
+    const auto ka = find(ta);
+    const auto kb = find(tb);
+    const auto a2 = unfolded[ka].position;
+    const auto b2 = unfolded[kb].position;
+    const auto previous = unfolded[3 - ka - kb].position;
+
+    // Place the new vertex on the other side of the shared edge.
+    //
+    const auto l = length(b2 - a2);
+    const auto e = (b2 - a2) / l;
+    const auto n = vec2{-e.y, e.x};
+    const auto ac = length2(position(c) - position(a));
+    const auto bc = length2(position(c) - position(b));
+    const auto x = (ac - bc + l * l) / (2 * l);
+    const auto y = sqrt(std::max(ac - x * x, 0.0f));
+    const auto side = (cross(a2, b2, previous) < 0) ? 1.0f : -1.0f;
+    const auto c2 = a2 + x * e + side * y * n;
+
+    flipped[i] = side < 0;
+    portals[i] = flipped[i] ? array{point{b2, tb}, point{a2, ta}}
+                            : array{point{a2, ta}, point{b2, tb}};
+    unfolded = {point{a2, ta}, point{b2, tb}, point{c2, topological_vertex(c)}};
+  }
+  const auto dst = barycenter();
+
+  // Funnel algorithm of Lee and Preparata.
+  // The funnel is kept in a deque with the left chain below
+  // and the right chain above the apex.
+  // Every portal only adds one new vertex on one of both sides.
+  // So, every vertex is pushed and popped at most once.
+  //
+  vector<point> funnel(2 * m + 3);
+  size_t head = m + 1;
+  size_t apex = head;
+  size_t tail = head;
+  funnel[apex] = {src};
+  vector<point> corners{funnel[apex]};
+
+  const auto add_right = [&](point p) {
+    while ((tail > apex) &&
+           (cross(funnel[tail - 1].position, funnel[tail].position,
+                  p.position) >= 0))
+      --tail;
+    if (tail == apex) {
+      while ((head < apex) && (cross(funnel[apex].position,
+                                     funnel[apex - 1].position,
+                                     p.position) >= 0))
+        corners.push_back(funnel[--apex]);
+      tail = apex;
     }
-  } while (!queue.empty() && !visited[dst]);
+    funnel[++tail] = p;
+  };
+  const auto add_left = [&](point p) {
+    while ((head < apex) &&
+           (cross(funnel[head + 1].position, funnel[head].position,
+                  p.position) <= 0))
+      ++head;
+    if (head == apex) {
+      while ((apex < tail) && (cross(funnel[apex].position,
+                                     funnel[apex + 1].position,
+                                     p.position) <= 0))
+        corners.push_back(funnel[++apex]);
+      head = apex;
+    }
+    funnel[--head] = p;
+  };
 
-  if (queue.empty()) return {};
+  add_left(portals[0][0]);
+  add_right(portals[0][1]);
+  for (size_t i = 1; i < m; ++i) {
+    if (portals[i][0].id == portals[i - 1][0].id)
+      add_right(portals[i][1]);
+    else
+      add_left(portals[i][0]);
+  }
+  add_right({dst});
+  for (auto i = apex + 1; i <= tail; ++i) corners.push_back(funnel[i]);
+
+  // Intersect the portals with the segments of the shortest path.
+  // Portals incident to a corner are crossed in the corner itself.
+  //
+  size_t k = 0;
+  bool at_corner = false;
+  for (size_t i = 0; i < m; ++i) {
+    const auto& [left, right] = portals[i];
+    float32 t = 0.5f;
+    while (true) {
+      const auto id = corners[k + 1].id;
+      if ((id != invalid) && (id == left.id)) {
+        t = 0;
+        at_corner = true;
+        break;
+      }
+      if ((id != invalid) && (id == right.id)) {
+        t = 1;
+        at_corner = true;
+        break;
+      }
+      if (at_corner) {
+        ++k;
+        at_corner = false;
+        continue;
+      }
+      const auto p = corners[k].position;
+      const auto d = corners[k + 1].position - p;
+      const auto r = right.position - left.position;
+      const auto det = d.x * r.y - d.y * r.x;
+      const auto q = p - left.position;
+      if (det != 0) t = std::clamp((d.x * q.y - d.y * q.x) / det, 0.0f, 1.0f);
+      break;
+    }
+    curve.edge_weights[i] = flipped[i] ? 1 - t : t;
+  }
+}
+
+auto polyhedral_surface::shortest_surface_mesh_curve(face_id src,
+                                                     face_id dst) const
+    -> surface_mesh_curve {
+  face_search search{};
+  return shortest_surface_mesh_curve(src, dst, search);
+}
+
+auto polyhedral_surface::shortest_surface_mesh_curve(face_id src,
+                                                     face_id dst,
+                                                     face_search& search) const
+    -> surface_mesh_curve {
+  search.run(*this, src, dst);
+  if (!search.reached(dst)) return {};
+  const auto previous = [&](face_id fid) { return search.predecessor(fid); };
 
   // Compute count and path.
   uint32 count = 0;
-  // for (auto i = dst; i != src; i = (previous[i] >> 2)) ++count;
-  for (auto i = dst; i != src; i = (face_adjacencies[i][previous[i]] >> 2))
-    ++count;
+  for (auto i = dst; i != src; i = (previous(i) >> 2)) ++count;
 
   surface_mesh_curve curve;
   curve.face_strip.resize(count);
   curve.edge_weights.assign(count, 0.5f);
 
-  // vector<uint32> path(count);
-  // for (auto i = dst; i != src; i = (previous[i] >> 2))
-  //   path[--count] = uint32(i << 2) | uint32(previous[i] & 0b11);
-  for (auto i = dst; i != src;) {
-    curve.face_strip[--count] = (i << 2) | previous[i];
-    i = (face_adjacencies[i][previous[i]] >> 2);
+  // Every face of the strip stores the location
+  // of its edge shared with the previous face.
+  for (auto i = dst; i != src; i = (previous(i) >> 2)) {
+    const auto pfid = previous(i) >> 2;
+    const auto ploc = previous(i) & 0b11;
+    const auto loc = face_adjacencies[pfid][ploc] & 0b11;
+    curve.face_strip[--count] = (i << 2) | loc;
   }
   return curve;
 }
 
-void polyhedral_surface::add_face(surface_mesh_curve& curve,
-                                  face_id fid) const {
+auto polyhedral_surface::add_face(surface_mesh_curve& curve,
+                                  face_id fid) const -> size_t {
+  face_search search{};
+  return add_face(curve, fid, search);
+}
+
+auto polyhedral_surface::add_face(surface_mesh_curve& curve,
+                                  face_id fid,
+                                  face_search& search) const -> size_t {
   if (curve.face_strip.empty()) {
     curve.face_strip.push_back(fid << 2);
-    return;
+    return 0;
   }
 
   const auto last = curve.face_strip.back() >> 2;
-  if (fid == last) return;
+  if (fid == last) return curve.face_strip.size();
 
-  auto path = shortest_surface_mesh_curve(last, fid);
+  auto path = shortest_surface_mesh_curve(last, fid, search);
 
+  // Going back along the curve removes its last faces.
+  auto first = curve.face_strip.size();
   for (size_t i = 0; i < path.size(); ++i) {
     if (curve.face_strip.size() > 1) {
       const auto last = curve.face_strip.back();
@@ -128,6 +615,7 @@ void polyhedral_surface::add_face(surface_mesh_curve& curve,
       if (face_adjacencies[last_fid][last_loc] == path.face_strip[i]) {
         curve.face_strip.pop_back();
         curve.edge_weights.pop_back();
+        first = std::min(first, curve.face_strip.size());
         continue;
       }
     }
@@ -135,6 +623,7 @@ void polyhedral_surface::add_face(surface_mesh_curve& curve,
     curve.face_strip.push_back(path.face_strip[i]);
     curve.edge_weights.push_back(path.edge_weights[i]);
   }
+  return first;
 }
 
 auto polyhedral_surface::critical_points_from(
@@ -172,11 +661,9 @@ auto polyhedral_surface::critical_points_from(
       const auto inner = position(faces[fid2][(loc1 + 2 - step) % 3]);
       points.push_back(inner);
       step = s;
-      cout << i - 1 << ", ";
+      logging::trace("critical point at strip index ", i - 1);
     }
   }
-  cout << curve.face_strip.size() - 1;
-  cout << endl;
 
   return points;
 }
@@ -215,28 +702,43 @@ void surface_mesh_curve::generate_control_points(
   // }
   // if (closed()) control_points.push_back(control_points.front());
 
-  control_points.clear();
-  if (face_strip.empty()) return;
-  control_points.reserve(face_strip.size() + 1);
-
-  if (!closed())
-    control_points.push_back(
-        surface.position(face_strip.front() >> 2, 1 / 3.0f, 1 / 3.0f));
-  else
-    control_points.push_back({});
-
-  for (size_t i = 0; i < face_strip.size() - 1; ++i) {
-    const auto e =
-        surface.common_edge(face_strip[i] >> 2, face_strip[i + 1] >> 2);
-    control_points.push_back(surface.position(e, edge_weights[i]));
-  }
+  update_control_points(surface, 0);
+}
 
-  if (!closed())
-    control_points.push_back(
-        surface.position(face_strip.back() >> 2, 1 / 3.0f, 1 / 3.0f));
-  else {
-    control_points.front() = control_points.back();
-    control_points.push_back(control_points[1]);
+void surface_mesh_curve::update_control_points(
+    const polyhedral_surface& surface,
+    size_t first) {
+  if (face_strip.empty()) {
+    control_points.clear();
+    return;
+  }
+  const auto n = face_strip.size();
+  control_points.resize(n + 1);
+
+  // The location of every face but the last one
+  // references the edge shared with the next face.
+  // The adjacent face and its location give the same edge
+  // in the orientation used for the edge weights.
+  //
+  parallel_for(
+      first, n - 1,
+      [&](size_t i) {
+        const auto f = face_strip[i];
+        const auto next = surface.face_adjacencies[f >> 2][f & 0b11];
+        assert((next >> 2) == (face_strip[i + 1] >> 2));
+        control_points[i + 1] =
+            surface.position(surface.face_edge(next), edge_weights[i]);
+      },
+      4096);
+
+  if (!closed()) {
+    control_points.front() =
+        surface.position(face_strip.front() >> 2, 1 / 3.0f, 1 / 3.0f);
+    control_points.back() =
+        surface.position(face_strip.back() >> 2, 1 / 3.0f, 1 / 3.0f);
+  } else {
+    control_points.front() = control_points[n - 1];
+    control_points.back() = control_points[1];
   }
 }
 
@@ -254,7 +756,11 @@ void surface_mesh_curve::add_face(uint32 f, const polyhedral_surface& surface) {
     face_strip.back() = (fid << 2) | surface.location(fid, path.front() >> 2);
 
   for (auto x : path) {
-    if (remove_artifacts(x >> 2)) continue;
+    // The remaining face needs the location of the next one.
+    if (remove_artifacts(x >> 2)) {
+      face_strip.back() = x;
+      continue;
+    }
     face_strip.push_back(x);
     edge_weights.push_back(0.5f);
   }
@@ -289,7 +795,11 @@ void surface_mesh_curve::close(const polyhedral_surface& surface) {
     face_strip.back() = (fid2 << 2) | surface.location(fid2, path.front() >> 2);
 
   for (auto x : path) {
-    if (remove_artifacts(x >> 2)) continue;
+    // The remaining face needs the location of the next one.
+    if (remove_artifacts(x >> 2)) {
+      face_strip.back() = x;
+      continue;
+    }
     face_strip.push_back(x);
     edge_weights.push_back(0.5f);
   }
@@ -303,18 +813,58 @@ bool surface_mesh_curve::closed() const {
          ((face_strip.front() >> 2) == (face_strip.back() >> 2));
 }
 
-void surface_mesh_curve::smooth(const polyhedral_surface& surface) {
-  if (face_strip.size() < 4) return;
+auto surface_mesh_curve::smooth(const polyhedral_surface& surface,
+                                float32 tolerance,
+                                size_t max_iterations) -> smoothing_report {
+  smoothing_report report{};
+  if (face_strip.size() < 4) return report;
+  const auto m = edge_weights.size();
+  const auto is_closed = closed();
+
+  // Local iterations only slowly propagate changes along the strip.
+  // Open curves are therefore first straightened by the funnel algorithm
+  // which needs every face to store the location of its previous edge.
+  // The iterations then only confirm the convergence.
+  //
+  if (!is_closed) {
+    polyhedral_surface::surface_mesh_curve strip{};
+    strip.face_strip.resize(face_strip.size());
+    strip.face_strip.front() = face_strip.front();
+    for (size_t i = 1; i < face_strip.size(); ++i) {
+      const auto f = face_strip[i - 1];
+      strip.face_strip[i] = surface.face_adjacencies[f >> 2][f & 0b11];
+    }
+    strip.edge_weights = std::move(edge_weights);
+    surface.straighten(strip);
+    edge_weights = std::move(strip.edge_weights);
+  }
 
   generate_control_points(surface);
 
-  const auto relax = [&](const auto& l, const auto& r, const auto& v1,
-                         const auto& v2, float t0) {
-    const auto p = r - v1;
-    const auto q = l - v1;
+  // The edge vertices are gathered once and reused by all iterations.
+  //
+  edge_vertices.resize(m);
+  parallel_for(
+      0, m,
+      [&](size_t i) {
+        const auto f = face_strip[i];
+        const auto e =
+            surface.face_edge(surface.face_adjacencies[f >> 2][f & 0b11]);
+        edge_vertices[i] = {surface.position(e[0]), surface.position(e[1])};
+      },
+      4096);
+
+  // Move the point on edge 'i' towards the intersection of the edge
+  // with the straight line between both neighboring control points
+  // in the unfolding of both adjacent faces.
+  // Return the absolute change of its weight.
+  //
+  const auto relax = [&](size_t i) {
+    const auto& [v1, v2] = edge_vertices[i];
+    const auto p = control_points[i + 2] - v1;
+    const auto q = control_points[i] - v1;
     const auto v = v2 - v1;
-    const auto vl = length(v);
-    const auto ivl = 1 / vl;
+    const auto ivl = 1 / length(v);
     const auto vn = ivl * v;
 
     const auto py = dot(p, vn);
@@ -322,39 +872,63 @@ void surface_mesh_curve::smooth(const polyhedral_surface& surface) {
     const auto px = -length(p - py * vn);
     const auto qx = length(q - qy * vn);
 
-    const auto t = (py * qx - qy * px) / (qx - px) * ivl;
-    const auto relaxation = 0.5f;
-    return std::clamp((1 - relaxation) * t0 + relaxation * t, 0.0f, 1.0f);
+    // Both neighbors on the edge line, for example in a common vertex,
+    // do not determine the intersection.
+    const auto t0 = edge_weights[i];
+    const auto d = qx - px;
+    const auto t = (d > 1e-4f * length(v)) ? (py * qx - qy * px) / d * ivl : t0;
+    // Points close to a vertex are snapped to it.
+    // Otherwise, rounding errors let points in a corner of the curve
+    // oscillate and the iteration would never meet the tolerance.
+    constexpr auto snap = 1e-3f;
+    const auto w = (t < snap) ? 0.0f : (t > 1 - snap) ? 1.0f : t;
+    edge_weights[i] = w;
+    control_points[i + 1] = (1 - w) * v1 + w * v2;
+    return abs(w - t0);
   };
 
-  // for (size_t i = 1; i < control_points.size() - 1; ++i) {
-  //   const auto fl = face_strip[i - 1] >> 2;
-  //   const auto fr = face_strip[i] >> 2;
-  //   const auto e = surface.common_edge(fl, fr);
-  //   edge_weights[i - 1] = relax(control_points[i - 1], control_points[i + 1],
-  //                               surface.position(e[0]),
-  //                               surface.position(e[1]), edge_weights[i - 1]);
-  // }
-
-  vector<float> new_edge_weights(edge_weights.size());
-  for (size_t i = 0; i < edge_weights.size(); ++i) {
-    const auto fl = face_strip[i] >> 2;
-    const auto fr = face_strip[i + 1] >> 2;
-    const auto e = surface.common_edge(fl, fr);
-    new_edge_weights[i] =
-        relax(control_points[i], control_points[i + 2], surface.position(e[0]),
-              surface.position(e[1]), edge_weights[i]);
+  // Points on edges of the same parity do not depend on each other.
+  // So, every half sweep is done in parallel.
+  // For closed curves with an odd number of edges,
+  // the first and the last edge are neighbors
+  // and the last one is relaxed separately.
+  //
+  const auto wrap = [&] {
+    if (!is_closed) return;
+    control_points.front() = control_points[m];
+    control_points.back() = control_points[1];
+  };
+  const auto half_sweep = [&](size_t first, size_t last) {
+    atomic<float32> residual{0};
+    const auto count = (last - first + 1) / 2;
+    parallel_for_chunks(
+        0, count,
+        [&](size_t a, size_t b) {
+          float32 r = 0;
+          for (auto k = a; k < b; ++k) r = std::max(r, relax(first + 2 * k));
+          auto current = residual.load();
+          while ((r > current) && !residual.compare_exchange_weak(current, r)) {
+          }
+        },
+        4096);
+    wrap();
+    return residual.load();
+  };
+  const auto lone = is_closed && (m % 2 == 1);
+  const auto even_last = lone ? m - 1 : m;
+
+  while (report.iterations < max_iterations) {
+    ++report.iterations;
+    auto residual = half_sweep(0, even_last);
+    residual = std::max(residual, half_sweep(1, m));
+    if (lone) {
+      residual = std::max(residual, relax(m - 1));
+      wrap();
+    }
+    report.residual = residual;
+    if (residual <= tolerance) break;
   }
-  edge_weights.swap(new_edge_weights);
-
-  // if (closed()) {
-  //   const auto fl = face_strip.front() >> 2;
-  //   const auto fr = face_strip[1] >> 2;
-  //   const auto e = surface.common_edge(fl, fr);
-  //   edge_weights[0] = relax(control_points[control_points.size() - 2],
-  //                           control_points[1], surface.position(e[0]),
-  //                           surface.position(e[1]), edge_weights[0]);
-  // }
+  return report;
 }
 
 auto surface_mesh_curve::reflect(size_t first,
@@ -375,15 +949,21 @@ auto surface_mesh_curve::reflect(size_t first,
   const auto step = (3 + loc2 - loc) % 3;
   const auto inner =
       surface.position(surface.faces[fid2][(loc + 2 - step) % 3]);
-  auto outer1 = result.control_points[result.control_points.size() - 2];
-  auto outer2 = surface.position(surface.faces[fid2][(loc + step - 1) % 3]);
+  auto outer = surface.faces[fid2][(loc + step - 1) % 3];
 
+  const auto angle = [&](vec3 x, vec3 y) {
+    return acos(dot(normalize(x - inner), normalize(y - inner)));
+  };
   auto curve_angle =
-      acos(dot(normalize(outer1 - inner), normalize(outer2 - inner)));
-  outer1 = outer2;
+      angle(result.control_points[result.control_points.size() - 2],
+            surface.position(outer));
 
+  // Inside the fan, successive outer vertices span
+  // the corner angle of a face at the inner vertex.
+  //
   size_t i = first + 1;
   for (; i < face_strip.size() - 1; ++i) {
+    const auto corner = surface.corner_angles[fid2][(loc + 2 - step) % 3];
     f = surface.face_adjacencies[fid2][loc2];
     fid = f >> 2;
     loc = f & 0b11;
@@ -393,10 +973,8 @@ auto surface_mesh_curve::reflect(size_t first,
     const auto s = (3 + loc2 - loc) % 3;
     if (s != step) break;
 
-    outer2 = surface.position(surface.faces[fid2][(loc + step - 1) % 3]);
-    curve_angle +=
-        acos(dot(normalize(outer1 - inner), normalize(outer2 - inner)));
-    outer1 = outer2;
+    curve_angle += corner;
+    outer = surface.faces[fid2][(loc + step - 1) % 3];
   }
 
   size_t index = i;
@@ -406,11 +984,9 @@ auto surface_mesh_curve::reflect(size_t first,
   // else
   //   cout << "left" << endl;
 
-  outer2 = control_points[index + 1];
-  curve_angle +=
-      acos(dot(normalize(outer1 - inner), normalize(outer2 - inner)));
+  curve_angle += angle(surface.position(outer), control_points[index + 1]);
 
-  cout << "curve angle = " << curve_angle * 180 / pi << "°" << endl;
+  logging::trace("curve angle = ", curve_angle * 180 / pi, "°");
 
   if (curve_angle <= pi) {
     for (size_t i = first; i < index; ++i) {
@@ -418,13 +994,9 @@ auto surface_mesh_curve::reflect(size_t first,
       result.edge_weights.push_back(edge_weights[i - 1]);
     }
   } else {
-    for (size_t i = first; i <= index; ++i) {
-      const auto f = face_strip[i];
-      const auto fid = f >> 2;
-      const auto loc = f & 0b11;
-      cout << "(" << fid << "," << loc << ") ";
-    }
-    cout << endl;
+    logging::trace("reflect ",
+                   face_strip_format{span(face_strip).subspan(
+                       first, index - first + 1)});
 
     const auto rstep = (step == 1) ? 2 : 1;
     const auto shift = (step == 1) ? -1 : 1;
@@ -432,30 +1004,33 @@ auto surface_mesh_curve::reflect(size_t first,
     const auto flast = face_strip[index] >> 2;
     f = result.face_strip.back();
     result.face_strip.pop_back();
-    result.edge_weights.pop_back();
+    // The first face of the strip has no edge weight.
+    if (!result.edge_weights.empty()) result.edge_weights.pop_back();
     fid = f >> 2;
     const auto ffirst = fid;
     loc = ((f & 0b11) + 3 + shift) % 3;
+    const auto reflected = result.face_strip.size();
     i = 0;
     while (fid != flast) {
-      cout << "(" << fid << "," << loc << ") ";
       result.face_strip.push_back((fid << 2) | loc);
-      result.edge_weights.push_back(0.5f);
+      if (result.face_strip.size() > 1) result.edge_weights.push_back(0.5f);
 
       f = surface.face_adjacencies[fid][loc];
       if (f == polyhedral_surface::invalid) {
-        cout << "invalid path" << endl;
+        logging::warning("reflection reached the boundary");
         break;
       }
       fid = f >> 2;
       loc = ((f & 0b11) + 3 + rstep) % 3;
       ++i;
       if (fid == ffirst) {
-        cout << "endless loop detected" << endl;
+        logging::warning("reflection ran into an endless loop");
         break;
       }
     }
-    cout << endl;
+    logging::trace(
+        "reflected to ",
+        face_strip_format{span(result.face_strip).subspan(reflected)});
   }
 
   return index;
@@ -465,27 +1040,29 @@ auto surface_mesh_curve::reflect(const polyhedral_surface& surface)
     -> surface_mesh_curve {
   // if (face_strip.size() < 5) return;
 
-  cout << "Reflection" << endl;
-  for (size_t i = 0; i < face_strip.size(); ++i) {
-    const auto f = face_strip[i];
-    const auto fid = f >> 2;
-    const auto loc = f & 0b11;
-    cout << "(" << fid << "," << loc << ")";
-  }
-  cout << endl << endl;
+  const logging::scope timing{"reflection"};
+  logging::trace("reflection of ", face_strip_format{face_strip});
 
+  generate_control_points(surface);
   surface_mesh_curve result{};
 
+  // Every step only appends to the result
+  // or replaces its last face and edge weight.
+  // So, only control points from the second to last edge on are updated.
+  //
   size_t index = 1;
   result.face_strip.push_back(face_strip.front());
   result.generate_control_points(surface);
   while (index < face_strip.size() - 1) {
+    const auto n = result.face_strip.size();
     index = reflect(index, surface, result);
-    result.generate_control_points(surface);
-    cout << "index = " << index << endl;
+    result.update_control_points(surface, (n < 2) ? 0 : n - 2);
+    logging::trace("reflection index = ", index);
   }
+  const auto n = result.face_strip.size();
   result.face_strip.push_back(face_strip.back());
   result.edge_weights.push_back(edge_weights.back());
+  result.update_control_points(surface, n - 1);
 
   // auto f = face_strip[0];
   // auto fid = f >> 2;
@@ -597,6 +1174,15 @@ auto surface_mesh_curve::reflect(const polyhedral_surface& surface)
   return result;
 }
 
+auto reflect(const polyhedral_surface& surface, span<surface_mesh_curve> curves)
+    -> vector<surface_mesh_curve> {
+  vector<surface_mesh_curve> result(curves.size());
+  parallel_for(
+      0, curves.size(),
+      [&](size_t i) { result[i] = curves[i].reflect(surface); }, 1);
+  return result;
+}
+
 void surface_mesh_curve::print(const polyhedral_surface& surface) {
   auto fid = face_strip.front() >> 2;
   auto loc = face_strip.front() & 0b11;
@@ -7,20 +7,51 @@ struct surface_mesh_curve {
   void clear();
   bool remove_artifacts(uint32 f);
   void generate_control_points(const polyhedral_surface& surface);
+  /// Only recompute the control points of edges from index 'first' on
+  /// and the end points after the strip has changed from there.
+  ///
+  void update_control_points(const polyhedral_surface& surface, size_t first);
   void add_face(uint32 f, const polyhedral_surface& surface);
   void remove_closed_artifacts();
   void close(const polyhedral_surface& surface);
   bool closed() const;
-  void smooth(const polyhedral_surface& surface);
+
+  struct smoothing_report {
+    size_t iterations{};
+    // Largest change of an edge weight in the last iteration.
+    float32 residual{};
+  };
+  /// Straighten the curve by red-black Gauss-Seidel iterations
+  /// until no edge weight changes by more than the tolerance.
+  /// Open curves start from the exact result of the funnel algorithm.
+  /// Closed curves have no fixed end points and rely on the iterations.
+  ///
+  auto smooth(const polyhedral_surface& surface,
+              float32 tolerance = 1e-4f,
+              size_t max_iterations = 10'000) -> smoothing_report;
+
   auto reflect(size_t first,
                const polyhedral_surface& surface,
                surface_mesh_curve& result);
+  /// Reflect the curve over all vertices it bends around by more than 'pi'.
+  /// The control points of the result are updated incrementally
+  /// and fan angles are summed from the corner angles of the surface.
+  /// So, the reflection runs in linear time of the curve length.
+  ///
   auto reflect(const polyhedral_surface& surface) -> surface_mesh_curve;
   void print(const polyhedral_surface& surface);
 
   vector<uint32> face_strip;
   vector<float32> edge_weights;
   vector<vec3> control_points;
+  // Reusable buffer of edge vertex positions for smoothing.
+  vector<array<vec3, 2>> edge_vertices;
 };
 
+/// Reflect independent curves in parallel.
+/// Every curve is reflected by its own task.
+///
+auto reflect(const polyhedral_surface& surface, span<surface_mesh_curve> curves)
+    -> vector<surface_mesh_curve>;
+
 }  // namespace nanoreflex
@@ -1,9 +1,26 @@
 #include <nanoreflex/viewer.hpp>
 //
+#include <nanoreflex/log.hpp>
 #include <nanoreflex/math.hpp>
+#include <nanoreflex/parallel.hpp>
 
 namespace nanoreflex {
 
+namespace {
+
+// Aligned line of statistics printed to the console.
+//
+void print_row(czstring name, const auto& value, czstring unit = "") {
+  constexpr auto left_width = 20;
+  constexpr auto right_width = 10;
+  cout << setprecision(3) << fixed << boolalpha;
+  cout << setw(left_width) << name << " = " << setw(right_width) << value;
+  if (*unit) cout << ' ' << unit;
+  cout << '\n';
+}
+
+}  // namespace
+
 viewer_context::viewer_context() {
   sf::ContextSettings settings;
   settings.majorVersion = 4;
@@ -75,8 +92,30 @@ void viewer::process_events() {
         case sf::Mouse::Middle:
           look_at(event.mouseButton.x, event.mouseButton.y);
           break;
+        case sf::Mouse::Left:
+          if (sf::Keyboard::isKeyPressed(sf::Keyboard::LControl)) {
+            selection_start = {event.mouseButton.x, event.mouseButton.y};
+            selecting = true;
+          }
+          break;
+      }
+    } else if (event.type == sf::Event::MouseButtonReleased) {
+      if (event.mouseButton.button == sf::Mouse::Left && selecting) {
+        selecting = false;
+        // Holding shift additionally selects occluded faces.
+        select_faces(selection_start.x, selection_start.y, event.mouseButton.x,
+                     event.mouseButton.y,
+                     !sf::Keyboard::isKeyPressed(sf::Keyboard::LShift));
+      }
+      // Straighten the curve once its drawing has been finished.
+      if (event.mouseButton.button == sf::Mouse::Right) {
+        curve_drawing.wait();
+        fetch_surface_curve();
+        straighten_surface_curve();
       }
     } else if (event.type == sf::Event::KeyPressed) {
+      // Keys may change the state shared with the curve worker.
+      curve_drawing.wait();
       switch (event.key.code) {
         case sf::Keyboard::Escape:
           running = false;
@@ -112,9 +151,37 @@ void viewer::process_events() {
         case sf::Keyboard::Z:
           sort_surface_faces_by_depth();
           break;
+        case sf::Keyboard::T:
+          toggle_triangle_cache();
+          break;
+        case sf::Keyboard::B:
+          benchmark_ray_tracing();
+          break;
+        case sf::Keyboard::P:
+          benchmark_face_paths();
+          break;
+        case sf::Keyboard::D:
+          benchmark_distance_field();
+          break;
+        case sf::Keyboard::G:
+          measure_geodesic_distances();
+          break;
+        case sf::Keyboard::L:
+          generate_landmarks();
+          break;
+        case sf::Keyboard::H:
+          generate_patches();
+          break;
+        case sf::Keyboard::I:
+          select_curve_region();
+          break;
+        case sf::Keyboard::K:
+          cut_surface_along_curve();
+          break;
         case sf::Keyboard::C:
           close_surface_curve();
           compute_surface_curve_points();
+          straighten_surface_curve();
           break;
         case sf::Keyboard::R:
           // smooth_curve.reflect(surface);
@@ -126,17 +193,17 @@ void viewer::process_events() {
   }
 
   if (window.hasFocus()) {
-    if (sf::Mouse::isButtonPressed(sf::Mouse::Left)) {
+    if (sf::Mouse::isButtonPressed(sf::Mouse::Left) && !selecting) {
       if (sf::Keyboard::isKeyPressed(sf::Keyboard::LShift))
         shift({mouse_move.x, mouse_move.y});
       else
         turn({-0.01 * mouse_move.x, 0.01 * mouse_move.y});
     }
 
-    if (sf::Mouse::isButtonPressed(sf::Mouse::Right)) {
+    if (sf::Mouse::isButtonPressed(sf::Mouse::Right) &&
+        !surface_load_task.valid()) {
       if (mouse_move != sf::Vector2i{}) {
         add_surface_curve_points(mouse_pos.x, mouse_pos.y);
-        compute_surface_curve_points();
       }
     }
 
@@ -172,6 +239,7 @@ void viewer::update_view() {
 
 void viewer::update() {
   handle_surface_load_task();
+  fetch_surface_curve();
   if (view_should_update) {
     update_view();
     view_should_update = false;
@@ -206,11 +274,13 @@ void viewer::render() {
   selection.bind();
   glDrawElements(GL_TRIANGLES, 3 * selection.size() / sizeof(GL_UNSIGNED_INT),
                  GL_UNSIGNED_INT, 0);
+  curve_selection.bind();
+  glDrawElements(GL_TRIANGLES, curve_selection_indices.size(),
+                 GL_UNSIGNED_INT, 0);
 
   shaders.names["boundary"]->second.shader.bind();
   surface_boundary.bind();
-  glDrawElements(GL_LINES, surface_boundary.size() / sizeof(GL_UNSIGNED_INT),
-                 GL_UNSIGNED_INT, 0);
+  glDrawElements(GL_LINES, surface_boundary_lines.size(), GL_UNSIGNED_INT, 0);
 
   glDepthFunc(GL_ALWAYS);
 
@@ -275,7 +345,7 @@ void viewer::zoom(float scale) {
 
 void viewer::look_at(float x, float y) {
   const auto r = cam.primary_ray(x, y);
-  if (const auto p = intersection(r, surface)) {
+  if (const auto p = intersection(r, surface, surface_tree)) {
     origin = r(p.t);
     radius = p.t;
     view_should_update = true;
@@ -309,15 +379,24 @@ void viewer::load_surface(const filesystem::path& path) {
       surface.generate_topological_structure();
       const auto preprocess_end = clock::now();
 
+      const auto bvh_start = clock::now();
+      surface_tree = surface_bvh_from(surface);
+      const auto bvh_end = clock::now();
+      geodesics = {};
+      landmarks = {};
+      patches = {};
+
       // Evaluate loading and processing time.
       surface_load_time = duration<float32>(load_end - load_start).count();
       surface_process_time =
           duration<float32>(preprocess_end - preprocess_start).count();
+      surface_bvh_time = duration<float32>(bvh_end - bvh_start).count();
     } catch (exception& e) {
       cout << "failed.\n" << e.what() << endl;
       return;
     }
   };
+  curve_drawing.wait();
   surface_load_task = async(launch::async, loader, path);
   cout << "Loading " << path << "..." << endl;
 }
@@ -335,24 +414,17 @@ void viewer::handle_surface_load_task() {
   fit_view();
   print_surface_info();
 
-  vector<uint32> lines{};
-  for (size_t fid = 0; fid < surface.faces.size(); ++fid) {
-    if (surface.face_adjacencies[fid][0] == polyhedral_surface::invalid) {
-      lines.push_back(surface.faces[fid][0]);
-      lines.push_back(surface.faces[fid][1]);
-    }
-    if (surface.face_adjacencies[fid][1] == polyhedral_surface::invalid) {
-      lines.push_back(surface.faces[fid][1]);
-      lines.push_back(surface.faces[fid][2]);
-    }
-    if (surface.face_adjacencies[fid][2] == polyhedral_surface::invalid) {
-      lines.push_back(surface.faces[fid][2]);
-      lines.push_back(surface.faces[fid][0]);
-    }
-  }
-  surface_boundary.allocate_and_initialize(lines);
+  update_surface_edges();
+}
 
-  lines.clear();
+void viewer::update_surface_edges() {
+  surface_boundary_lines.clear();
+  surface_boundary_capacity = 0;
+  for (size_t fid = 0; fid < surface.faces.size(); ++fid)
+    add_surface_boundary_lines(fid);
+  upload_surface_boundary_lines(0);
+
+  vector<uint32> lines{};
   for (const auto& [e, info] : surface.edges) {
     if (info.oriented()) continue;
     const auto e2 = surface.common_edge(info.face[0], info.face[1]);
@@ -371,6 +443,29 @@ void viewer::handle_surface_load_task() {
   surface_inconsistent_edges.allocate_and_initialize(lines);
 }
 
+void viewer::add_surface_boundary_lines(polyhedral_surface::face_id fid) {
+  const auto& f = surface.faces[fid];
+  for (size_t i = 0; i < 3; ++i) {
+    if (surface.face_adjacencies[fid][i] != polyhedral_surface::invalid)
+      continue;
+    surface_boundary_lines.push_back(f[i]);
+    surface_boundary_lines.push_back(f[(i + 1) % 3]);
+  }
+}
+
+void viewer::upload_surface_boundary_lines(size_t first) {
+  const auto& lines = surface_boundary_lines;
+  if (lines.size() > surface_boundary_capacity) {
+    surface_boundary_capacity =
+        std::max(lines.size(), 2 * surface_boundary_capacity);
+    surface_boundary.allocate(surface_boundary_capacity * sizeof(uint32));
+    first = 0;
+  }
+  if (first < lines.size())
+    surface_boundary.write(lines.data() + first, lines.size() - first,
+                           first * sizeof(uint32));
+}
+
 void viewer::fit_view() {
   const auto box = aabb_from(surface);
   origin = box.origin();
@@ -381,30 +476,249 @@ void viewer::fit_view() {
 }
 
 void viewer::print_surface_info() {
-  constexpr auto left_width = 20;
-  constexpr auto right_width = 10;
-  cout << setprecision(3) << fixed << boolalpha;
-  cout << setw(left_width) << "load time"
-       << " = " << setw(right_width) << surface_load_time << " s\n"
-       << setw(left_width) << "process time"
-       << " = " << setw(right_width) << surface_process_time << " s\n"
-       << '\n';
-
-  cout << setw(left_width) << "vertices"
-       << " = " << setw(right_width) << surface.vertices.size() << '\n'
-       << setw(left_width) << "faces"
-       << " = " << setw(right_width) << surface.faces.size() << '\n'
-       << setw(left_width) << "consistent"
-       << " = " << setw(right_width) << surface.consistent() << '\n'
-       << setw(left_width) << "oriented"
-       << " = " << setw(right_width) << surface.oriented() << '\n'
-       << setw(left_width) << "boundary"
-       << " = " << setw(right_width) << surface.has_boundary() << '\n'
-       << setw(left_width) << "components"
-       << " = " << setw(right_width) << surface.component_count() << '\n'
+  print_row("load time", surface_load_time, "s");
+  print_row("process time", surface_process_time, "s");
+  print_row("bvh time", surface_bvh_time, "s");
+  // Phases are only recorded if debug tracing is compiled in.
+  for (const auto& e : logging::take_events())
+    print_row(e.name, e.duration, "s");
+  cout << '\n';
+
+  // By the Gauss-Bonnet theorem, all angle defects sum up
+  // to '2 pi' times the Euler characteristic.
+  //
+  const auto euler_characteristic =
+      lround(reduce(begin(surface.angle_defects), end(surface.angle_defects),
+                    float64(0)) /
+             (2 * pi));
+  print_row("vertices", surface.vertices.size());
+  print_row("faces", surface.faces.size());
+  print_row("consistent", surface.consistent());
+  print_row("oriented", surface.oriented());
+  print_row("boundary", surface.has_boundary());
+  print_row("components", surface.component_count());
+  print_row("euler characteristic", euler_characteristic);
+  print_row("bvh memory", surface_tree.memory_usage() / 1e6, "MB");
+  cout << endl;
+}
+
+void viewer::toggle_triangle_cache() {
+  if (surface_tree.cached())
+    surface_tree.clear_triangle_cache();
+  else
+    surface_tree.cache_triangles(surface);
+  cout << "triangle cache = " << boolalpha << surface_tree.cached() << '\n'
+       << "bvh memory = " << surface_tree.memory_usage() / 1e6 << " MB\n"
        << endl;
 }
 
+void viewer::benchmark_ray_tracing() {
+  // Trace one primary ray per pixel for the current view
+  // with and without the triangle cache.
+  //
+  const auto trace = [&] {
+    const auto start = clock::now();
+    size_t hits = 0;
+    for (int y = 0; y < cam.screen_height(); ++y)
+      for (int x = 0; x < cam.screen_width(); ++x)
+        if (intersection(cam.primary_ray(x, y), surface, surface_tree)) ++hits;
+    const auto end = clock::now();
+    return pair{duration<float32>(end - start).count(), hits};
+  };
+
+  const auto was_cached = surface_tree.cached();
+  surface_tree.clear_triangle_cache();
+  const auto [uncached_time, uncached_hits] = trace();
+  surface_tree.cache_triangles(surface);
+  const auto [cached_time, cached_hits] = trace();
+  const auto cache_memory =
+      surface.faces.size() * sizeof(surface_bvh::cached_triangle);
+  if (!was_cached) surface_tree.clear_triangle_cache();
+
+  const auto rays = cam.screen_width() * cam.screen_height();
+  print_row("rays", rays);
+  print_row("hits", cached_hits);
+  print_row("uncached time", uncached_time, "s");
+  print_row("uncached rate", rays / uncached_time / 1e6, "Mrays/s");
+  print_row("cached time", cached_time, "s");
+  print_row("cached rate", rays / cached_time / 1e6, "Mrays/s");
+  print_row("cache memory", cache_memory / 1e6, "MB");
+  cout << endl;
+  if (uncached_hits != cached_hits)
+    error("Ray tracing with and without triangle cache differs in hits.");
+}
+
+void viewer::benchmark_face_paths() {
+  // Search paths between faces of the same component
+  // that lie far apart in the face order of the component.
+  // Every exact strategy has to find paths of the same length.
+  // The hierarchical strategy may only find longer paths.
+  //
+  constexpr size_t queries = 16;
+  if (surface.faces.empty()) return;
+  using strategy = face_search::strategy;
+  const pair<strategy, czstring> strategies[] = {
+      {strategy::dijkstra, "dijkstra"},
+      {strategy::astar, "astar"},
+      {strategy::bidirectional, "bidirectional"},
+      {strategy::hierarchical, "hierarchical"}};
+
+  auto& search = path_search;
+  array<float32, queries> lengths{};
+  for (const auto& [s, name] : strategies) {
+    size_t expanded = 0;
+    float32 time = 0;
+    float32 max_time = 0;
+    float32 max_excess = 0;
+    bool same_lengths = true;
+    for (size_t q = 0; q < queries; ++q) {
+      const auto cid = q % surface.component_count();
+      const auto fids = surface.component_face_ids(cid);
+      const auto count = fids.size();
+      const auto src = fids[(q * 7919) % count];
+      const auto dst = fids[(q * 7919 + count / 2) % count];
+      const auto start = clock::now();
+      search.run(surface, src, dst, s);
+      const auto end = clock::now();
+      const auto t = duration<float32>(end - start).count();
+      time += t;
+      max_time = std::max(max_time, t);
+      expanded += search.expanded;
+
+      const auto length = search.path_length(dst);
+      if (s == strategy::dijkstra) lengths[q] = length;
+      const auto excess = length - lengths[q];
+      max_excess = std::max(max_excess, excess / std::max(lengths[q], 1e-6f));
+      if (s != strategy::hierarchical)
+        same_lengths &= abs(excess) <= 1e-4f * (1 + lengths[q]);
+    }
+
+    print_row("strategy", name);
+    print_row("path queries", queries);
+    print_row("mean time", 1e3f * time / queries, "ms");
+    print_row("max time", 1e3f * max_time, "ms");
+    print_row("mean expanded", float32(expanded) / queries);
+    print_row("max length excess", 1e2f * max_excess, "%");
+    cout << endl;
+    if (!same_lengths) error("Face path lengths differ from Dijkstra's.");
+  }
+}
+
+void viewer::benchmark_distance_field() {
+  // Use the faces of the current curve as sources
+  // or the first face if there is no curve.
+  //
+  if (surface.faces.empty()) return;
+  vector<polyhedral_surface::face_id> sources{};
+  for (auto f : curve.face_strip) sources.push_back(f >> 2);
+  if (sources.empty()) sources.push_back(0);
+
+  // Measure the scaling by doubling the thread count
+  // up to the concurrency of the hardware.
+  //
+  const auto max_threads = thread_count();
+  face_distance_field field{};
+  float32 serial_time = 0;
+  for (size_t threads = 1;; threads = std::min(2 * threads, max_threads)) {
+    set_thread_count(threads);
+    const auto start = clock::now();
+    field = face_distance_field_from(surface, sources);
+    const auto end = clock::now();
+    const auto time = duration<float32>(end - start).count();
+    if (threads == 1) serial_time = time;
+    print_row("threads", threads);
+    print_row("distance field time", time, "s");
+    print_row("speedup", serial_time / time);
+    if (threads == max_threads) break;
+  }
+  set_thread_count(0);
+
+  size_t reached = 0;
+  float32 max_distance = 0;
+  for (size_t fid = 0; fid < field.size(); ++fid) {
+    if (!field.reached(fid)) continue;
+    ++reached;
+    max_distance = std::max(max_distance, field.distances[fid]);
+  }
+
+  print_row("sources", sources.size());
+  print_row("reached faces", reached);
+  print_row("max distance", max_distance);
+  cout << endl;
+}
+
+void viewer::measure_geodesic_distances() {
+  if (surface.faces.empty()) return;
+  if (geodesics.empty()) {
+    const auto start = clock::now();
+    geodesics = heat_geodesics_from(surface);
+    const auto end = clock::now();
+    geodesics_time = duration<float32>(end - start).count();
+  }
+
+  // Measure from the start to the end of the current curve
+  // or from the face under the mouse cursor if there is no curve.
+  //
+  auto src = polyhedral_surface::invalid;
+  auto dst = polyhedral_surface::invalid;
+  if (!curve.face_strip.empty()) {
+    src = curve.face_strip.front() >> 2;
+    dst = curve.face_strip.back() >> 2;
+  } else {
+    const auto r = cam.primary_ray(mouse_pos.x, mouse_pos.y);
+    if (const auto p = intersection(r, surface, surface_tree)) src = p.f;
+  }
+  if (src == polyhedral_surface::invalid) return;
+  const auto vertex = [&](uint32 fid) {
+    return surface.topological_vertex(surface.faces[fid][0]);
+  };
+  const auto source = vertex(src);
+
+  const auto start = clock::now();
+  const auto distances = geodesics.distances(span(&source, 1));
+  const auto end = clock::now();
+  const auto time = duration<float32>(end - start).count();
+
+  float32 max_distance = 0;
+  for (auto d : distances)
+    if (d != infinity) max_distance = std::max(max_distance, d);
+
+  print_row("heat method time", geodesics_time, "s");
+  print_row("heat method memory", geodesics.memory_usage() / 1e6, "MB");
+  print_row("geodesic query time", 1e3f * time, "ms");
+  print_row("max distance", max_distance);
+  if (dst != polyhedral_surface::invalid)
+    print_row("curve end distance", distances[vertex(dst)]);
+  cout << endl;
+}
+
+void viewer::generate_landmarks() {
+  constexpr size_t count = 8;
+  const auto start = clock::now();
+  landmarks = face_landmarks_from(surface, count);
+  const auto end = clock::now();
+  path_search.landmarks = &landmarks;
+
+  print_row("landmarks", landmarks.size());
+  print_row("landmark time", duration<float32>(end - start).count(), "s");
+  print_row("landmark memory", landmarks.memory_usage() / 1e6, "MB");
+  cout << endl;
+}
+
+void viewer::generate_patches() {
+  constexpr size_t patch_size = 256;
+  const auto start = clock::now();
+  patches = face_patches_from(surface, patch_size);
+  const auto end = clock::now();
+  path_search.patches = &patches;
+  path_search.default_strategy = face_search::strategy::hierarchical;
+
+  print_row("patches", patches.size());
+  print_row("patch time", duration<float32>(end - start).count(), "s");
+  print_row("patch memory", patches.memory_usage() / 1e6, "MB");
+  cout << endl;
+}
+
 void viewer::load_shader(const filesystem::path& path, const string& name) {
   shaders.load_shader(path);
   shaders.add_name(path, name);
@@ -421,25 +735,114 @@ void viewer::select_face(float x, float y) {
   selected_faces.resize(surface.faces.size());
   for (size_t i = 0; i < selected_faces.size(); ++i) selected_faces[i] = false;
 
-  if (const auto p = intersection(cam.primary_ray(x, y), surface)) {
+  const auto r = cam.primary_ray(x, y);
+  if (const auto p = intersection(r, surface, surface_tree)) {
     selected_faces[p.f] = true;
     update_selection();
   }
 }
 
+void viewer::select_faces(
+    float x0, float y0, float x1, float y1, bool visible_only) {
+  const auto volume = cam.sub_frustum(x0, y0, x1, y1);
+  auto fids = faces_inside(volume, surface, surface_tree);
+  if (visible_only)
+    remove_occluded_faces(cam.position(), fids, surface, surface_tree);
+
+  selected_faces.assign(surface.faces.size(), false);
+  decltype(surface.faces) faces(fids.size());
+  for (size_t i = 0; i < fids.size(); ++i) {
+    selected_faces[fids[i]] = true;
+    faces[i] = surface.faces[fids[i]];
+  }
+  selection.allocate_and_initialize(faces);
+}
+
 void viewer::expand_selection() {
   auto new_selected_faces = selected_faces;
   for (size_t i = 0; i < selected_faces.size(); ++i) {
     if (!selected_faces[i]) continue;
     for (int j = 0; j < 3; ++j) {
       if (surface.face_adjacencies[i][j] == scene::invalid) continue;
-      new_selected_faces[surface.face_adjacencies[i][j]] = true;
+      new_selected_faces[surface.face_adjacencies[i][j] >> 2] = true;
     }
   }
   swap(new_selected_faces, selected_faces);
   update_selection();
 }
 
+void viewer::select_curve_region() {
+  if (!curve.closed()) {
+    cout << "The surface curve needs to be closed to bound a region.\n"
+         << endl;
+    return;
+  }
+  // Every call selects the other side of the curve.
+  region_left = !region_left;
+  const auto start = clock::now();
+  try {
+    selected_faces = surface.region_from(curve, region_left);
+  } catch (exception& e) {
+    cout << "Region selection failed.\n" << e.what() << '\n' << endl;
+    return;
+  }
+  const auto end = clock::now();
+  update_selection();
+  cout << "region side = " << (region_left ? "left" : "right") << '\n'
+       << "region faces = " << ranges::count(selected_faces, true) << '\n'
+       << "region time = " << duration<float32>(end - start).count() << " s\n"
+       << endl;
+}
+
+void viewer::cut_surface_along_curve() {
+  if (curve.size() == 0) {
+    cout << "The surface curve needs at least one point to cut along.\n"
+         << endl;
+    return;
+  }
+  const auto vertex_count = surface.vertices.size();
+  const auto face_count = surface.faces.size();
+  // Faces of the strip are changed in place.
+  vector<polyhedral_surface::face_id> changed{};
+  for (auto f : curve.face_strip) changed.push_back(f >> 2);
+  const auto cid = surface.component(changed.front());
+
+  const auto start = clock::now();
+  try {
+    surface.cut(curve);
+  } catch (exception& e) {
+    cout << "Cut failed.\n" << e.what() << '\n' << endl;
+    return;
+  }
+  const auto end = clock::now();
+
+  // Only the leaves of the cut faces are replaced in the hierarchy
+  // and split off components are added to it.
+  // The device buffers only receive changed and appended data.
+  // Global search structures are invalid and dropped.
+  //
+  surface_tree.update(surface, cid, changed, face_count);
+  geodesics = {};
+  landmarks = {};
+  patches = {};
+  reset_surface_curve_points();
+  selected_faces.clear();
+  update_selection();
+  surface.update(vertex_count, face_count, changed);
+  const auto first_line = surface_boundary_lines.size();
+  for (auto fid : changed) add_surface_boundary_lines(fid);
+  for (auto fid = face_count; fid < surface.faces.size(); ++fid)
+    add_surface_boundary_lines(fid);
+  upload_surface_boundary_lines(first_line);
+  const auto update_end = clock::now();
+
+  print_row("cut time", duration<float32>(end - start).count(), "s");
+  print_row("update time", duration<float32>(update_end - end).count(), "s");
+  print_row("faces", surface.faces.size());
+  print_row("components", surface.component_count());
+  cout << endl;
+}
+
 void viewer::select_component() {
   // selected_faces.resize(surface.faces.size());
   // for (size_t i = 0; i < surface.faces.size(); ++i)
@@ -453,27 +856,23 @@ void viewer::select_component() {
 }
 
 void viewer::reset_surface_curve_points() {
+  curve_drawing.clear();
   curve.clear();
   surface_curve_points.vertices.clear();
   surface_curve_points.update();
   smooth_curve_points.vertices.clear();
   smooth_curve_points.update();
-  selection.allocate_and_initialize(nullptr, 0);
+  curve_selection_indices.clear();
 }
 
 void viewer::add_surface_curve_points(float x, float y) {
-  const auto r = cam.primary_ray(x, y);
-  const auto p = intersection(r, surface);
-  if (!p) return;
+  // Picking and path search are done by the curve worker.
+  // Its results are fetched when the view is updated.
+  curve_drawing.request(cam.primary_ray(x, y));
 
   // curve.add_face(p.f, surface);
   // smooth_curve = curve;
 
-  surface.add_face(curve, p.f);
-  smooth_curve = curve;
-
-  assert(surface.valid(curve));
-
   // Compute edge weights
   // if (path.size() == 1) {
   //   const auto fid1 = curve_faces.back();
@@ -568,31 +967,54 @@ void viewer::add_surface_curve_points(float x, float y) {
   // curve_end = {p.u, p.v};
 }
 
-void viewer::compute_surface_curve_points() {
+void viewer::fetch_surface_curve() {
+  const auto first = curve_drawing.fetch(curve);
+  if (!first) return;
+  assert(surface.valid(curve));
+  compute_surface_curve_points(*first);
+}
+
+void viewer::compute_surface_curve_points(size_t first) {
   // surface_curve_points.vertices = points_from(surface, curve);
   // curve.generate_control_points(surface);
   // surface_curve_points.vertices = curve.control_points;
 
-  surface_curve_points.vertices = surface.points_from(curve);
-  surface_curve_points.update();
+  // Only the suffix of the curve starting at the first changed strip entry
+  // is recomputed and uploaded.
+  // The point on the edge of strip entry 'i' has index 'i - 1'.
+  //
+  const auto first_point = (first > 0) ? first - 1 : 0;
+  surface.update_points(curve, first_point, surface_curve_points.vertices);
+  surface_curve_points.update(first_point);
+
+  const auto& strip = curve.face_strip;
+  curve_selection_indices.resize(3 * strip.size());
+  for (auto i = first; i < strip.size(); ++i) {
+    const auto& f = surface.faces[strip[i] >> 2];
+    curve_selection_indices[3 * i + 0] = f[0];
+    curve_selection_indices[3 * i + 1] = f[1];
+    curve_selection_indices[3 * i + 2] = f[2];
+  }
+  if (curve_selection_indices.size() > curve_selection_capacity) {
+    curve_selection_capacity =
+        std::max(curve_selection_indices.size(), 2 * curve_selection_capacity);
+    curve_selection.allocate(curve_selection_capacity * sizeof(uint32));
+    first = 0;
+  }
+  if (first < strip.size())
+    curve_selection.write(curve_selection_indices.data() + 3 * first,
+                          3 * (strip.size() - first),
+                          3 * first * sizeof(uint32));
+}
 
+void viewer::straighten_surface_curve() {
   // smooth_curve_points.vertices = points_from(surface, smooth_curve);
   // smooth_curve.generate_control_points(surface);
   // smooth_curve_points.vertices = smooth_curve.control_points;
-  // polyhedral_surface::surface_mesh_curve c;
-  // c.face_strip = smooth_curve.face_strip;
-  // c.edge_weights = smooth_curve.edge_weights;
-  smooth_curve_points.vertices = surface.points_from(curve);
+  smooth_curve = curve;
+  surface.straighten(smooth_curve);
+  smooth_curve_points.vertices = surface.points_from(smooth_curve);
   smooth_curve_points.update();
-
-  vector<uint32> indices{};
-  for (auto fid : smooth_curve.face_strip) {
-    const auto& f = surface.faces[fid >> 2];
-    indices.push_back(f[0]);
-    indices.push_back(f[1]);
-    indices.push_back(f[2]);
-  }
-  selection.allocate_and_initialize(indices);
 }
 
 void viewer::close_surface_curve() {
@@ -613,6 +1035,9 @@ void viewer::sort_surface_faces_by_depth() {
     return d1 > d2;
   });
   surface.device_faces.allocate_and_initialize(faces);
+  // The device order differs from the host order.
+  // So, the next partial update has to upload all faces again.
+  surface.face_capacity = 0;
 }
 
 }  // namespace nanoreflex
@@ -1,9 +1,14 @@
 #pragma once
 #include <nanoreflex/camera.hpp>
+#include <nanoreflex/curve_worker.hpp>
+#include <nanoreflex/distance_field.hpp>
+#include <nanoreflex/face_search.hpp>
+#include <nanoreflex/heat_geodesics.hpp>
 #include <nanoreflex/opengl/opengl.hpp>
 #include <nanoreflex/points.hpp>
 #include <nanoreflex/polyhedral_surface.hpp>
 #include <nanoreflex/shader_manager.hpp>
+#include <nanoreflex/surface_bvh.hpp>
 #include <nanoreflex/surface_mesh_curve.hpp>
 #include <nanoreflex/utility.hpp>
 
@@ -47,20 +52,35 @@ class viewer : viewer_context {
 
   void load_surface(const filesystem::path& path);
   void handle_surface_load_task();
+  void update_surface_edges();
+  void add_surface_boundary_lines(polyhedral_surface::face_id fid);
+  void upload_surface_boundary_lines(size_t first);
   void fit_view();
   void print_surface_info();
+  void toggle_triangle_cache();
+  void benchmark_ray_tracing();
+  void benchmark_face_paths();
+  void benchmark_distance_field();
+  void measure_geodesic_distances();
+  void generate_landmarks();
+  void generate_patches();
 
   void load_shader(const filesystem::path& path, const string& name);
 
   void update_selection();
   void select_face(float x, float y);
+  void select_faces(float x0, float y0, float x1, float y1, bool visible_only);
   void expand_selection();
 
   void select_component();
+  void select_curve_region();
+  void cut_surface_along_curve();
 
   void reset_surface_curve_points();
   void add_surface_curve_points(float x, float y);
-  void compute_surface_curve_points();
+  void fetch_surface_curve();
+  void compute_surface_curve_points(size_t first = 0);
+  void straighten_surface_curve();
 
   void close_surface_curve();
 
@@ -95,10 +115,21 @@ class viewer : viewer_context {
   future<void> surface_load_task{};
   float32 surface_load_time{};
   float32 surface_process_time{};
+  float32 surface_bvh_time{};
   //
   float bounding_radius;
 
+  // Acceleration structure for picking with one hierarchy per component.
+  surface_bvh surface_tree{};
+
+  // Factorized heat method which is lazily built on first use.
+  heat_geodesics geodesics{};
+  float32 geodesics_time{};
+
   opengl::element_buffer surface_boundary{};
+  // Boundary lines grow with cuts and only their suffix is uploaded.
+  vector<uint32> surface_boundary_lines{};
+  size_t surface_boundary_capacity = 0;
   opengl::element_buffer surface_unoriented_edges{};
   opengl::element_buffer surface_inconsistent_edges{};
 
@@ -107,6 +138,11 @@ class viewer : viewer_context {
   opengl::element_buffer selection{};
 
   vector<bool> selected_faces{};
+  // Side of the closed surface curve selected last as region.
+  bool region_left = false;
+  // Screen position where a rectangle selection has been started.
+  sf::Vector2i selection_start{};
+  bool selecting = false;
   uint32 group = 0;
   bool orientation = false;
 
@@ -116,10 +152,26 @@ class viewer : viewer_context {
   // surface_mesh_curve smooth_curve{};
 
   polyhedral_surface::surface_mesh_curve curve{};
+  // Workspace for all face path searches while drawing curves.
+  face_search path_search{};
+  // Optional landmarks that speed up repeated path searches.
+  face_landmarks landmarks{};
+  // Optional patches to restrict path searches to corridors.
+  face_patches patches{};
   polyhedral_surface::surface_mesh_curve smooth_curve{};
   points surface_curve_points{};
   points smooth_curve_points{};
+  // Faces of the curve strip drawn as selection.
+  // The buffer grows geometrically to only upload changed suffixes.
+  opengl::element_buffer curve_selection{};
+  vector<uint32> curve_selection_indices{};
+  size_t curve_selection_capacity = 0;
   points critical_vertices{};
+
+  // Picks faces and searches paths for the curve in the background.
+  // It is declared last to be destroyed first
+  // because it uses the surface, its hierarchy, and the path search.
+  curve_worker curve_drawing{surface, surface_tree, path_search};
 };
 
 }  // namespace nanoreflex
@@ -0,0 +1,118 @@
+#include <nanoreflex/wide_bvh.hpp>
+
+namespace nanoreflex {
+
+namespace {
+
+constexpr auto surface_area(const aabb3& box) noexcept -> real {
+  const auto d = box._max - box._min;
+  return 2 * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+}  // namespace
+
+auto wide_bvh_from(bvh&& tree) -> wide_bvh {
+  constexpr auto width = wide_bvh::width;
+
+  wide_bvh result{};
+  if (tree.empty()) return result;
+
+  result.bounds = tree.box();
+  result.primitives = move(tree.primitives);
+  result.nodes.reserve(tree.nodes.size() / (width - 1) + 1);
+  result.nodes.emplace_back();
+
+  struct task {
+    bvh::index_type source;
+    wide_bvh::index_type target;
+  };
+  vector<task> tasks{{0, 0}};
+
+  while (!tasks.empty()) {
+    const auto [source, target] = tasks.back();
+    tasks.pop_back();
+
+    // Gather up to four descendants of the binary node
+    // by always opening the inner descendant with the largest surface area.
+    // A leaf root becomes the only child of the wide root.
+    //
+    array<bvh::index_type, width> children{};
+    size_t n = 0;
+    const auto& parent = tree.nodes[source];
+    if (parent.leaf())
+      children[n++] = source;
+    else {
+      children[n++] = parent.offset;
+      children[n++] = parent.offset + 1;
+    }
+    while (n < width) {
+      size_t best = width;
+      real best_area = -1;
+      for (size_t i = 0; i < n; ++i) {
+        const auto& child = tree.nodes[children[i]];
+        if (child.leaf()) continue;
+        const auto area = surface_area(child.box);
+        if (area <= best_area) continue;
+        best_area = area;
+        best = i;
+      }
+      if (best == width) break;
+      const auto offset = tree.nodes[children[best]].offset;
+      children[best] = offset;
+      children[n++] = offset + 1;
+    }
+
+    // Choose the smallest power-of-two grid spacing
+    // for which 255 steps still cover the parent box.
+    //
+    wide_bvh::node node{};
+    const auto& box = parent.box;
+    node.origin = box._min;
+    vec3 scale{};
+    for (int k = 0; k < 3; ++k) {
+      const auto extent = box._max[k] - box._min[k];
+      int e = (extent > 0) ? int(ceil(log2(extent / 255))) : -126;
+      e = std::clamp(e, -126, 127);
+      while (e < 127 && box._min[k] + 255 * ldexp(1.0f, e) < box._max[k]) ++e;
+      node.exponent[k] = e;
+      scale[k] = ldexp(1.0f, e);
+    }
+
+    // Quantize child boxes conservatively.
+    // Rounding errors are caught by explicitly checking the dequantization.
+    //
+    for (size_t i = 0; i < n; ++i) {
+      const auto& child = tree.nodes[children[i]];
+      for (int k = 0; k < 3; ++k) {
+        const auto o = node.origin[k];
+        const auto s = scale[k];
+        const auto min = child.box._min[k];
+        const auto max = child.box._max[k];
+        auto lo = int(std::clamp(floor((min - o) / s), 0.0f, 255.0f));
+        while (lo > 0 && o + lo * s > min) --lo;
+        auto hi = int(std::clamp(ceil((max - o) / s), 0.0f, 255.0f));
+        while (hi < 255 && o + hi * s < max) ++hi;
+        node.lo[k][i] = lo;
+        node.hi[k][i] = hi;
+      }
+
+      if (child.leaf()) {
+        assert(child.count <= 255);
+        node.count[i] = child.count;
+        node.child[i] = child.offset;
+      } else {
+        node.child[i] = result.nodes.size();
+        result.nodes.emplace_back();
+        tasks.push_back({children[i], node.child[i]});
+      }
+    }
+
+    result.nodes[target] = node;
+  }
+
+  // The binary nodes are not needed anymore.
+  tree = {};
+  return result;
+}
+
+}  // namespace nanoreflex
@@ -0,0 +1,111 @@
+#pragma once
+#include <nanoreflex/bvh.hpp>
+
+namespace nanoreflex {
+
+/// Compressed bounding volume hierarchy with four children per node.
+/// The boxes of all children are quantized to 8 bit per coordinate
+/// relative to a local grid that spans the box of their parent.
+/// The grid spacing per axis is a power of two
+/// and only stored by its exponent.
+/// So, a node with four children fits into a single cache line.
+/// Leaves are not stored as nodes but directly referenced by their parent.
+/// Coordinates are stored in a structure-of-arrays layout
+/// to test all children of a node at once by using SIMD instructions.
+///
+struct wide_bvh {
+  using index_type = uint32;
+  static constexpr size_t width = 4;
+  static constexpr index_type invalid = -1;
+
+  struct alignas(64) node {
+    constexpr bool empty(size_t i) const noexcept {
+      return child[i] == invalid;
+    }
+    constexpr bool leaf(size_t i) const noexcept { return count[i] != 0; }
+
+    auto scale() const noexcept -> vec3 {
+      const auto s = [](int8_t e) {
+        return bit_cast<float32>(uint32(e + 127) << 23);
+      };
+      return {s(exponent[0]), s(exponent[1]), s(exponent[2])};
+    }
+
+    /// Return the dequantized box of the given child.
+    ///
+    auto box(size_t i) const noexcept -> aabb3 {
+      const auto s = scale();
+      const auto q = [i](const uint8(&x)[3][width]) {
+        return vec3{float(x[0][i]), float(x[1][i]), float(x[2][i])};
+      };
+      aabb3 result{};
+      result._min = origin + s * q(lo);
+      result._max = origin + s * q(hi);
+      return result;
+    }
+
+    // Origin of the local quantization grid.
+    vec3 origin{};
+    // Power-of-two exponents of the grid spacing per axis.
+    int8_t exponent[3]{};
+    // The number of primitives for leaves or zero for inner nodes.
+    uint8 count[width]{};
+    // Quantized lower and upper box coordinates per axis and child.
+    uint8 lo[3][width]{};
+    uint8 hi[3][width]{};
+    // For inner nodes, the index of the child node.
+    // For leaves, the index of the first primitive in 'primitives'.
+    index_type child[width]{invalid, invalid, invalid, invalid};
+  };
+  static_assert(sizeof(node) == 64);
+
+  constexpr bool empty() const noexcept { return nodes.empty(); }
+  constexpr auto box() const noexcept -> aabb3 { return bounds; }
+
+  constexpr auto leaf_primitives(const node& n, size_t i) const noexcept {
+    assert(n.leaf(i));
+    return span(&primitives[n.child[i]], n.count[i]);
+  }
+
+  constexpr auto memory_usage() const noexcept -> size_t {
+    return nodes.size() * sizeof(node) +
+           primitives.size() * sizeof(index_type);
+  }
+
+  aabb3 bounds{};
+  vector<node> nodes{};
+  vector<index_type> primitives{};
+};
+
+/// Collapse a binary BVH into its compressed four-wide form.
+/// The primitive order of the binary hierarchy is kept.
+/// Leaves must not contain more than 255 primitives.
+///
+auto wide_bvh_from(bvh&& tree) -> wide_bvh;
+
+/// Call 'process(primitives)' for every leaf of the hierarchy
+/// whose boxes along the path to the root all fulfill 'accept(box)'.
+///
+inline void for_each_leaf(const wide_bvh& tree,
+                          auto&& accept,
+                          auto&& process) {
+  if (tree.empty()) return;
+  if (!accept(tree.box())) return;
+
+  // Every level may push all but one child at once.
+  wide_bvh::index_type stack[3 * 64];
+  size_t top = 0;
+  stack[top++] = 0;
+  while (top > 0) {
+    const auto& node = tree.nodes[stack[--top]];
+    for (size_t i = 0; i < wide_bvh::width; ++i) {
+      if (node.empty(i) || !accept(node.box(i))) continue;
+      if (node.leaf(i))
+        process(tree.leaf_primitives(node, i));
+      else
+        stack[top++] = node.child[i];
+    }
+  }
+}
+
+}  // namespace nanoreflex